@@ -21,75 +21,17 @@
 
 #include "logparser.h"
 #include "LogViewApp.h"
+#include "parallel.h"
 
 #include <algorithm>
-#include <gsl/gsl_complex_math.h>
-#include <gsl/gsl_errno.h>
-#include <gsl/gsl_fft_complex.h>
-#include <gsl/gsl_spline.h>
+#include <atomic>
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <wx/clipbrd.h>
 #include <wx/dcbuffer.h>
 
-void Spline::Init(const double *x, const double *y, size_t n)
-{
-    if (accel)
-        gsl_interp_accel_reset(static_cast<gsl_interp_accel *>(accel));
-    else
-        accel = gsl_interp_accel_alloc();
-
-    if (spline)
-        gsl_spline_free(static_cast<gsl_spline *>(spline));
-
-    spline = gsl_spline_alloc(gsl_interp_akima, n);
-
-    gsl_spline_init(static_cast<gsl_spline *>(spline), x, y, n);
-}
-
-Spline::~Spline()
-{
-    gsl_spline_free(static_cast<gsl_spline *>(spline));
-    gsl_interp_accel_free(static_cast<gsl_interp_accel *>(accel));
-}
-
-double Spline::Eval(double x) const
-{
-    return gsl_spline_eval(static_cast<gsl_spline *>(spline),
-        x, static_cast<gsl_interp_accel *>(accel));
-}
-
-struct LFit
-{
-    double avx, avy, varx, covxy, vary, n;
-    LFit() : avx(0.), avy(0.), varx(0.), covxy(0.), vary(0.), n(0.) { }
-    void data(double x, double y) {
-        double k = n;
-        n += 1.0;
-        k /= n;
-        double dx = x - avx;
-        double dy = y - avy;
-        varx += (k * dx * dx - varx) / n;
-        covxy += (k * dx * dy - covxy) / n;
-        vary += (k * dy * dy - vary) / n;
-        avx += dx / n;
-        avy += dy / n;
-    }
-    void reset() {
-        avx = avy = varx = covxy = vary = n = 0.;
-    }
-    // y = a + b x
-    double B() const { return n >= 2. ? covxy / varx : 0.; }
-    double A() const { return avy - B() * avx; }
-    void result(double *a, double *b) const {
-        *b = B();
-        *a = avy - *b * avx;
-    }
-    double Theta() const { return n >= 2. ? atan2(covxy, varx) : 0.; }
-};
-
-inline static bool Include(const GuideEntry& e)
-{
-    return e.included && StarWasFound(e.err);
-}
-
 static double DecDrift(const GuideSession::EntryVec& entries)
 {
     if (entries.size() < 2)
@@ -180,11 +122,39 @@ static double PolarAlignError(const GuideSession& session)
     return 3.8197 * fabs(session.drift_dec) * session.pixelScale / cos(session.declination);
 }
 
+static double Elongation(double a, double b)
+{
+    if (a < b)
+        std::swap(a, b);
+
+    return (a + b) > 1e-6 ?
+        (a - b) / (a + b) :
+        1.;
+}
+
 void GuideSession::CalcStats()
 {
-    LFit fitrd;
+    LFit& fitrd = err_moments;
     double peak_r = 0., peak_d = 0.;
 
+    err_dist.Reset();
+    fitrd.reset();
+    exp_time = exp_err2 = 0.;
+
+    // Weight each frame by the exposure. When the header does not give it,
+    // the frame interval stands in, capped at the median interval so that
+    // a frame after a pause, a settle or an excluded run does not take the
+    // whole gap as its weight.
+    double fexp_max = exposure;
+    if (fexp_max <= 0. && entries.size() > 1)
+    {
+        std::vector<float> gaps(entries.size() - 1);
+        for (size_t i = 1; i < entries.size(); i++)
+            gaps[i - 1] = entries[i].dt - entries[i - 1].dt;
+        std::nth_element(gaps.begin(), gaps.begin() + gaps.size() / 2, gaps.end());
+        fexp_max = gaps[gaps.size() / 2];
+    }
+
     for (auto it = entries.begin(); it != entries.end(); ++it)
     {
         const GuideEntry& e = *it;
@@ -192,6 +162,23 @@ void GuideSession::CalcStats()
             continue;
 
         fitrd.data(e.raraw, e.decraw);
+        double r = hypot(e.raraw, e.decraw);
+        err_dist.Add(r);
+
+        double fexp = exposure;
+        if (fexp <= 0.)
+        {
+            if (it != entries.begin())
+                fexp = it->dt - (it - 1)->dt;
+            else if (it + 1 != entries.end())
+                fexp = (it + 1)->dt - it->dt;
+            fexp = std::min(fexp, fexp_max);
+        }
+        if (fexp > 0.)
+        {
+            exp_time += fexp;
+            exp_err2 += fexp * r * r;
+        }
 
         if (fabs(e.raraw) > fabs(peak_r))
             peak_r = e.raraw;
@@ -206,6 +193,12 @@ void GuideSession::CalcStats()
     peak_ra = peak_r;
     peak_dec = peak_d;
 
+    median_err = err_dist.Quantile(0.5);
+    p90_err = err_dist.Quantile(0.9);
+    p95_err = err_dist.Quantile(0.95);
+    p99_err = err_dist.Quantile(0.99);
+    exp_rms = exp_time > 0. ? sqrt(exp_err2 / exp_time) : 0.;
+
     // angle of elongation
     theta = fitrd.Theta();
 
@@ -214,6 +207,7 @@ void GuideSession::CalcStats()
     double cost = cos(theta), sint = sin(theta);
 
     LFit fitxy;
+    QuantileSketch dev; // absolute deviations from the median error
     for (auto it = entries.begin(); it != entries.end(); ++it)
     {
         const GuideEntry& e = *it;
@@ -226,191 +220,139 @@ void GuideSession::CalcStats()
         double y = dd * cost - dr * sint;
 
         fitxy.data(x, y);
+        dev.Add(fabs(hypot(e.raraw, e.decraw) - median_err));
     }
 
     lx = sqrt(fitxy.varx);
     ly = sqrt(fitxy.vary);
+    mad_err = dev.Quantile(0.5);
 
-    {
-        double a = lx, b = ly;
-        if (a < b)
-            std::swap(a, b);
-
-        elongation = (a + b) > 1e-6 ?
-                (a - b) / (a + b) :
-                1.;
-    }
+    elongation = Elongation(lx, ly);
 
     drift_ra = RaDrift(entries) * 60.;   // pixels per minute
     drift_dec = DecDrift(entries) * 60.;
     paerr = PolarAlignError(*this);
 }
 
-GARun::~GARun()
+void GuideSession::CalcRangeStats(size_t begin, size_t end, RangeStats& st) const
 {
-    delete[] t;
-    delete[] rac;
-    delete[] decc;
-    delete[] fftx;
-    delete[] ffty;
+    end = std::min(end, entries.size());
+
+    QuantileSketch dist;
+    for (size_t i = begin; i < end; i++)
+        if (Include(entries[i]))
+            dist.Add(hypot(entries[i].raraw, entries[i].decraw));
+
+    st.count = dist.Count();
+    st.median = dist.Quantile(0.5);
+    st.p90 = dist.Quantile(0.9);
+    st.p95 = dist.Quantile(0.95);
+    st.p99 = dist.Quantile(0.99);
+
+    QuantileSketch dev;
+    for (size_t i = begin; i < end; i++)
+        if (Include(entries[i]))
+            dev.Add(fabs(hypot(entries[i].raraw, entries[i].decraw) - st.median));
+    st.mad = dev.Quantile(0.5);
 }
 
-struct Line
+void GuideLog::CalcSummaryMAD()
 {
-    double a, b;
-    Line(const LFit& lf) {
-        lf.result(&a, &b);
-    }
-    double operator()(double x) { return a + b * x; }
-};
-
-bool GARun::CanAnalyze(const GuideSession& session, size_t begin, size_t end)
-{
-    const auto& entries = session.entries;
-    const auto& p0 = entries.begin() + begin;
-    const auto& p1 = entries.begin() + end;
-
-    enum { MIN_ENTRIES = 12 }; // need at least 12 for FFT output spline (N / 2 - 1 >= 5)
-
-    size_t n = 0;
-    for (auto it = p0; it != p1; ++it)
-        if (Include(*it) && ++n >= MIN_ENTRIES)
-            return true;
-
-    return false;
-}
-
-void GARun::Analyze(const GuideSession& session, size_t begin, size_t end, bool undo_ra_corrections)
-{
-    starts = session.starts;
-    pixscale = session.pixelScale;
-
-    const auto& entries = session.entries;
-    const auto& p0 = entries.begin() + begin;
-    const auto& p1 = entries.begin() + end;
-
-    size_t n = std::count_if(p0, p1, &Include);
-
-    delete[] t;
-    delete[] rac;
-    delete[] decc;
-    delete[] fftx;
-    delete[] ffty;
-
-    len = n;
-    t = new double[n];
-    double *ra = new double[n];
-    double *dec = new double[n];
-    rac = new double[n];
-    decc = new double[n];
-
-    LFit fitR; // ra fit
-    LFit fitD; // dec fit
-
-    double *pt = &t[0];
-    double *pra = &ra[0];
-    double *pdec = &dec[0];
-
-    {
-        double rapos = 0.;
-        double prev_raguide = 0.;
-        double prev_raraw = 0.;
-
-        for (auto it = p0; it != p1; ++it)
-        {
-            const GuideEntry& e = *it;
-            if (Include(e))
-            {
-                double const raraw = e.raraw;
-                double const raguide = e.raguide;
-                double const move = raraw - prev_raraw - prev_raguide;
-                rapos += move;
-                prev_raraw = raraw;
-                prev_raguide = undo_ra_corrections ? raguide : 0.;
-
-                *pt++ = e.dt;
-                *pra++ = rapos;
-                *pdec++ = e.decraw;
-
-                fitR.data(e.dt, rapos);
-                fitD.data(e.dt, e.decraw);
-            }
-        }
-    }
-
-    // drift correction
-
-    Line lR(fitR);
-    Line lD(fitD);
+    if (summary_mad_valid)
+        return;
 
-    pt = &t[0];
-    pra = &ra[0];
-    pdec = &dec[0];
-    double *prac = &rac[0];
-    double *pdecc = &decc[0];
-    while (prac < &rac[n])
+    // the MAD needs the deviations from the whole-log median, so it takes
+    // a pass over the frames, as it does for a session
+    GuideSession& s = summary;
+    QuantileSketch dev;
+    for (auto it = sessions.begin(); it != sessions.end(); ++it)
     {
-        double t = *pt++;
-        *prac++ = *pra++ - lR(t);
-        *pdecc++ = *pdec++ - lD(t);
+        double k = it->pixelScale / s.pixelScale;
+        for (auto e = it->entries.begin(); e != it->entries.end(); ++e)
+            if (Include(*e))
+                dev.Add(fabs(hypot(e->raraw, e->decraw) * k - s.median_err));
     }
+    s.mad_err = dev.Quantile(0.5);
+    summary_mad_valid = true;
+}
 
-    // interpolate RA to get uniform samples for FFT
+void GuideLog::CalcSummary()
+{
+    GuideSession& s = summary;
 
-    double *data = new double[n * 2];
+    // express everything in the pixel scale of the longest session
+    const GuideSession *ref = 0;
+    for (auto it = sessions.begin(); it != sessions.end(); ++it)
+        if (!ref || it->duration > ref->duration)
+            ref = &*it;
 
-    double dt = (t[n - 1] - t[0]) / (double) (n - 1);
+    s.pixelScale = ref ? ref->pixelScale : 1.;
+    s.declination = ref ? ref->declination : 0.;
+    s.duration = 0.;
+    s.err_moments.reset();
+    s.err_dist.Reset();
+    s.exp_time = s.exp_err2 = 0.;
 
-    {
-        double const k = M_PI * 2.0 / (double) (n - 1);
-        Spline spline(t, rac, n);
-        double x = t[0];
-        for (unsigned int i = 0; i < n; i++, x += dt)
-        {
-            if (x > t[n - 1]) x = t[n - 1]; // rounding error can put the last point over the boundary
-            // Hamming window
-            double const hw = 0.54 - 0.46 * cos(i * k);
-            data[i * 2] = hw * spline.Eval(x);
-            data[i * 2 + 1] = 0.;
-        }
-    }
-
-    // FFT
+    double peak_r = 0., peak_d = 0.;
+    double drift_r = 0., drift_d = 0., pa = 0., dur = 0.;
 
+    for (auto it = sessions.begin(); it != sessions.end(); ++it)
     {
-        gsl_fft_complex_workspace *work = gsl_fft_complex_workspace_alloc(n);
-        gsl_fft_complex_wavetable *wt = gsl_fft_complex_wavetable_alloc(n);
-
-        gsl_fft_complex_forward(data, 1, n, wt, work);
-
-        gsl_fft_complex_wavetable_free(wt);
-        gsl_fft_complex_workspace_free(work);
+        const GuideSession& gs = *it;
+        s.duration += gs.duration;
+        if (gs.err_moments.n == 0.)
+            continue;
 
-        nfft = n / 2 - 1; // omit steady state f=0
-        fftx = new double[nfft];
-        ffty = new double[nfft];
+        double k = gs.pixelScale / s.pixelScale;
 
-        double scale = 4. / (double) n; // http://www.stat.ucla.edu/~frederic/221/W17/221ch4a.pdf
-        fftymax = 0.;
+        s.err_moments.merge(gs.err_moments, k);
+        s.err_dist.Merge(gs.err_dist, k);
+        s.exp_time += gs.exp_time;
+        s.exp_err2 += gs.exp_err2 * k * k;
 
-        for (size_t i = 0; i < nfft; i++)
-        {
-            const gsl_complex *pz = (const gsl_complex *) (&data[(i + 1) * 2]);
-            double f = (double) (i + 1) / ((double) n * dt);
-            double p = 1. / f;
-            fftx[nfft - 1 - i] = p;
-            double a = gsl_complex_abs(*pz) * scale;
-            ffty[nfft - 1 - i] = a;
-            if (a > fftymax)
-                fftymax = a;
-        }
+        if (fabs(gs.peak_ra * k) > fabs(peak_r))
+            peak_r = gs.peak_ra * k;
+        if (fabs(gs.peak_dec * k) > fabs(peak_d))
+            peak_d = gs.peak_dec * k;
 
-        ffts.Init(fftx, ffty, nfft);
+        // drift and polar alignment error are weighted by session duration
+        drift_r += gs.drift_ra * k * gs.duration;
+        drift_d += gs.drift_dec * k * gs.duration;
+        pa += gs.paerr * gs.duration;
+        dur += gs.duration;
     }
 
-    delete[] data;
-    delete[] ra;
-    delete[] dec;
+    const LFit& m = s.err_moments;
+    s.rms_ra = sqrt(m.varx);
+    s.rms_dec = sqrt(m.vary);
+    s.avg_ra = m.avx;
+    s.avg_dec = m.avy;
+    s.peak_ra = peak_r;
+    s.peak_dec = peak_d;
+
+    s.median_err = s.err_dist.Quantile(0.5);
+    s.p90_err = s.err_dist.Quantile(0.9);
+    s.p95_err = s.err_dist.Quantile(0.95);
+    s.p99_err = s.err_dist.Quantile(0.99);
+    s.exp_rms = s.exp_time > 0. ? sqrt(s.exp_err2 / s.exp_time) : 0.;
+
+    // same as the per-session stats, but the variances along the rotated
+    // axes come straight from the merged covariance
+    s.theta = m.Theta();
+    double cost = cos(s.theta), sint = sin(s.theta);
+    double vx = cost * cost * m.varx + 2. * cost * sint * m.covxy + sint * sint * m.vary;
+    double vy = sint * sint * m.varx - 2. * cost * sint * m.covxy + cost * cost * m.vary;
+    s.lx = sqrt(std::max(vx, 0.));
+    s.ly = sqrt(std::max(vy, 0.));
+    s.elongation = Elongation(s.lx, s.ly);
+
+    // the MAD is left to CalcSummaryMAD
+    s.mad_err = 0.;
+    summary_mad_valid = false;
+
+    s.drift_ra = dur > 0. ? drift_r / dur : 0.;
+    s.drift_dec = dur > 0. ? drift_d / dur : 0.;
+    s.paerr = dur > 0. ? pa / dur : 0.;
 }
 
 struct DragInfo
@@ -438,14 +380,31 @@ struct FFTPos : public GraphPos
     int xw; // width of spline domain in screen coordinates
     double p0, p1; // bounds of spline domain
 
+    // RA and Dec amplitudes at screen x = k + floor(xofs) for k in
+    // [ck0, ck0 + size), filled in as needed; UNSET if not yet evaluated.
+    // Panning by whole pixels leaves the samples valid, so the cache is
+    // only reset on zoom, resize or new data.
+    enum { CACHE_SCREENS = 3 };
+    static double Unset() { return -HUGE_VAL; } // the spline can dip below 0
+    std::vector<double> cache[2];
+    long ck0;
+    double cfrac; // fractional part of xofs the cache was filled for
+    double cscx;
+
     void Init(const wxSize& sz, const GARun& ga_)
     {
         ga = &ga_;
         HReset(sz.x);
         VReset(sz.y);
     }
+    void Invalidate()
+    {
+        cache[0].clear();
+        cache[1].clear();
+    }
     void HReset(int width)
     {
+        Invalidate();
         x0 = PADX;
         xofs = (double) x0;
         x1 = width - PADX;
@@ -463,6 +422,8 @@ struct FFTPos : public GraphPos
     }
     void Resize(const wxSize& sz)
     {
+        Invalidate();
+
         // x-axis
         double k0 = ((double) x0 - xofs) * scx;
         double k1 = ((double) x1 - xofs) * scx;
@@ -484,6 +445,7 @@ struct FFTPos : public GraphPos
         xofs = (double) center - scx * ((double) center - xofs) / tscx;
         scx = tscx;
         xw = (int) floor(log(p1 / p0) / scx);
+        Invalidate();
     }
     void VZoom(double d)
     {
@@ -497,24 +459,63 @@ struct FFTPos : public GraphPos
     {
         return (int)(floor(log(p / p0) / scx + xofs));
     }
-    int Eval(int x)
+    const Spline& Curve(bool dec) const
     {
-        double p = P(x);
-        double a = ga->ffts.Eval(p);
-        return y0 - (int)(a * scy);
+        return dec ? ga->fftds : ga->ffts;
+    }
+    void ResetCache(double fl)
+    {
+        size_t n = CACHE_SCREENS * (size_t) std::max(x1 - x0 + 1, 1);
+        cache[0].assign(n, Unset());
+        cache[1].assign(n, Unset());
+        ck0 = (long) x0 - (long) fl - (long) n / CACHE_SCREENS;
+        cfrac = xofs - fl;
+        cscx = scx;
+    }
+    // move the cache window so that it is centered on k, keeping the
+    // samples that are still inside it
+    void SlideCache(long k)
+    {
+        long const n = (long) cache[0].size();
+        long const nk0 = k - n / 2;
+        long const d = nk0 - ck0;
+        for (int c = 0; c < 2; c++)
+        {
+            std::vector<double>& v = cache[c];
+            if (d > 0 && d < n)
+            {
+                std::copy(v.begin() + d, v.end(), v.begin());
+                std::fill(v.end() - d, v.end(), Unset());
+            }
+            else if (d < 0 && -d < n)
+            {
+                std::copy_backward(v.begin(), v.end() + d, v.end());
+                std::fill(v.begin(), v.begin() - d, Unset());
+            }
+            else
+                std::fill(v.begin(), v.end(), Unset());
+        }
+        ck0 = nk0;
     }
-    double FEval(int x)
+    int Eval(int x, bool dec)
     {
-        double p = P(x);
-        return ga->ffts.Eval(p);
+        double a = FEval(x, dec);
+        return y0 - (int)(a * scy);
     }
-    void Eval(int x, int *y, double *pp, double *pa)
+    double FEval(int x, bool dec)
     {
-        double p = P(x);
-        double a = ga->ffts.Eval(p);
-        *y = y0 - (int)(a * scy);
-        *pp = p;
-        *pa = a;
+        double const fl = floor(xofs);
+        if (cache[0].empty() || xofs - fl != cfrac || scx != cscx)
+            ResetCache(fl);
+
+        long const k = (long) x - (long) fl;
+        if (k < ck0 || k >= ck0 + (long) cache[0].size())
+            SlideCache(k);
+
+        double& a = cache[dec ? 1 : 0][k - ck0];
+        if (a == Unset())
+            a = Curve(dec).Eval(P(x));
+        return a;
     }
     int StartX() const
     {
@@ -611,6 +612,385 @@ struct DriftPos : public GraphPos
 };
 static DriftPos s_drpos;
 
+// Colour rendering of a spectrogram. The colours of every window at every
+// screen row are kept, so panning and zooming the time axis only picks
+// different columns; they are recomputed when the data, the axis shown,
+// the graph height or the gain change.
+struct SgramView
+{
+    unsigned int gen;
+    int which;
+    int height;
+    double gain;
+    std::vector<unsigned char> rgb; // height rows of nwin pixels
+    std::vector<int> col;           // window shown in each screen column, -1 for none
+    wxImage img;
+
+    SgramView() : gen(0), which(-1), height(0), gain(1.0) { }
+
+    // period shown at row r, rows count down from the longest period
+    static double Period(const Spectrogram& sg, int height, double r)
+    {
+        double const phi = 1. / sg.df;
+        double const plo = 1. / ((double) sg.nf * sg.df);
+        return phi * exp(-r / (double) std::max(height - 1, 1) * log(phi / plo));
+    }
+    static double Row(const Spectrogram& sg, int height, double p)
+    {
+        double const phi = 1. / sg.df;
+        double const plo = 1. / ((double) sg.nf * sg.df);
+        return log(phi / p) / log(phi / plo) * (double) std::max(height - 1, 1);
+    }
+    static size_t Bin(const Spectrogram& sg, double p)
+    {
+        double k = floor(1. / (p * sg.df) + 0.5) - 1.;
+        return (size_t) std::min(std::max(k, 0.), (double) (sg.nf - 1));
+    }
+    static int Window(const Spectrogram& sg, const GARun& ga, double t)
+    {
+        if (t < ga.t[0] || t > ga.t[ga.len - 1])
+            return -1;
+        double w = floor((t - sg.t0) / sg.tstep + 0.5);
+        return (int) std::min(std::max(w, 0.), (double) (sg.nwin - 1));
+    }
+
+    void Update(const Spectrogram& sg, int which_, int height_)
+    {
+        if (gen == sg.gen && which == which_ && height == height_ && rgb.size())
+            return;
+
+        gen = sg.gen;
+        which = which_;
+        height = height_;
+
+        size_t const nwin = sg.nwin;
+        rgb.resize((size_t) height * nwin * 3);
+
+        double const scale = sg.ampmax[which] > 0.f ? gain / sqrt((double) sg.ampmax[which]) : 0.;
+
+        ParallelFor((size_t) height, [&](size_t r) {
+            size_t const k = Bin(sg, Period(sg, height, (double) r));
+            unsigned char *px = &rgb[r * nwin * 3];
+            for (size_t w = 0; w < nwin; w++, px += 3)
+            {
+                // black - red - yellow - white
+                double v = std::min(sqrt((double) sg.amp[which][w * sg.nf + k]) * scale, 1.0) * 3.0;
+                px[0] = (unsigned char) (255. * std::min(v, 1.0));
+                px[1] = (unsigned char) (255. * std::min(std::max(v - 1.0, 0.), 1.0));
+                px[2] = (unsigned char) (255. * std::min(std::max(v - 2.0, 0.), 1.0));
+            }
+        });
+    }
+    void SetGain(double g)
+    {
+        gain = g;
+        rgb.clear();
+    }
+};
+static SgramView s_sgview;
+
+// Runs analyses on a single background thread. Submitting a request
+// cancels the one running and replaces any pending one, so repeated
+// requests never queue up; only the latest result is delivered.
+class AnalysisWorker : public AnalysisMonitor
+{
+    struct Request
+    {
+        GARun *run; // loaded data, owned by the request
+        AnalysisKey key;
+        bool sgram; // only the spectrogram of a processed run, for its key's Welch settings
+        Request() : run(nullptr), sgram(false) { }
+    };
+
+    AnalysisWin *m_win;
+    std::mutex m_lock;
+    std::condition_variable m_cond;
+    bool m_quit;
+    Request m_pending;
+    bool m_running;
+    bool m_restart;             // re-run the current request with m_runOpts
+    SpectrumOptions m_runOpts;
+    Request m_done;             // finished, waiting for the UI thread
+    std::atomic<bool> m_cancel;
+    std::atomic<int> m_progress;
+    std::thread m_thread;
+
+    void Run();
+
+public:
+    AnalysisWorker(AnalysisWin *win);
+    ~AnalysisWorker();
+
+    void Submit(GARun *run, const AnalysisKey& key, bool sgram = false);
+    // an analysis is pending or running
+    bool Busy();
+    // change the spectrum options of the outstanding request, returns false if idle
+    bool Respectrum(const SpectrumOptions& opts);
+    // drop the outstanding request
+    void Cancel();
+    GARun *TakeResult(AnalysisKey *key, bool *sgram);
+
+    bool Cancelled() const override { return m_cancel; }
+    void Progress(int percent) override;
+};
+
+AnalysisWorker::AnalysisWorker(AnalysisWin *win)
+    :
+    m_win(win),
+    m_quit(false),
+    m_running(false),
+    m_restart(false),
+    m_cancel(false),
+    m_progress(0)
+{
+    m_thread = std::thread(&AnalysisWorker::Run, this);
+}
+
+AnalysisWorker::~AnalysisWorker()
+{
+    {
+        std::lock_guard<std::mutex> lck(m_lock);
+        m_quit = true;
+        m_cancel = true;
+    }
+    m_cond.notify_one();
+    m_thread.join();
+
+    delete m_pending.run;
+    delete m_done.run;
+}
+
+void AnalysisWorker::Submit(GARun *run, const AnalysisKey& key, bool sgram)
+{
+    {
+        std::lock_guard<std::mutex> lck(m_lock);
+        delete m_pending.run; // superseded
+        m_pending.run = run;
+        m_pending.key = key;
+        m_pending.sgram = sgram;
+        if (m_running)
+        {
+            m_restart = false;
+            m_cancel = true;
+        }
+    }
+    m_cond.notify_one();
+}
+
+bool AnalysisWorker::Busy()
+{
+    std::lock_guard<std::mutex> lck(m_lock);
+    return m_pending.run || m_running;
+}
+
+bool AnalysisWorker::Respectrum(const SpectrumOptions& opts)
+{
+    std::lock_guard<std::mutex> lck(m_lock);
+    if (m_pending.run)
+    {
+        m_pending.key.opts = opts;
+        return true;
+    }
+    if (m_running)
+    {
+        m_runOpts = opts;
+        m_restart = true;
+        m_cancel = true;
+        return true;
+    }
+    return false;
+}
+
+void AnalysisWorker::Cancel()
+{
+    std::lock_guard<std::mutex> lck(m_lock);
+    delete m_pending.run;
+    m_pending.run = nullptr;
+    delete m_done.run;
+    m_done.run = nullptr;
+    if (m_running)
+    {
+        m_restart = false;
+        m_cancel = true;
+    }
+}
+
+GARun *AnalysisWorker::TakeResult(AnalysisKey *key, bool *sgram)
+{
+    std::lock_guard<std::mutex> lck(m_lock);
+    GARun *run = m_done.run;
+    *key = m_done.key;
+    *sgram = m_done.sgram;
+    m_done.run = nullptr;
+    return run;
+}
+
+void AnalysisWorker::Progress(int percent)
+{
+    if (m_progress.exchange(percent) != percent)
+        m_win->CallAfter(&AnalysisWin::OnAnalysisProgress, percent);
+}
+
+void AnalysisWorker::Run()
+{
+    std::unique_lock<std::mutex> lck(m_lock);
+
+    while (true)
+    {
+        m_cond.wait(lck, [this]() { return m_quit || m_pending.run; });
+        if (m_quit)
+            break;
+
+        Request req = m_pending;
+        m_pending.run = nullptr;
+        m_running = true;
+        m_restart = false;
+        m_cancel = false;
+
+        bool ok;
+        while (true)
+        {
+            lck.unlock();
+            m_progress = 0;
+            if (req.sgram)
+                ok = req.run->CalcSpectrogram(req.key.opts.segment, req.key.opts.overlap, this);
+            else
+                ok = req.run->Process(req.key.opts, this);
+            lck.lock();
+
+            // the spectrum options changed while running, re-run even if
+            // Process finished before it saw the cancel
+            if (m_quit || !m_restart)
+                break;
+
+            // a spectrum change makes it a full analysis again
+            req.key.opts = m_runOpts;
+            req.sgram = false;
+            m_restart = false;
+            m_cancel = false;
+        }
+
+        m_running = false;
+
+        if (ok && !m_cancel && !m_pending.run && !m_quit)
+        {
+            delete m_done.run;
+            m_done = req;
+            m_win->CallAfter(&AnalysisWin::OnAnalysisDone);
+        }
+        else
+            delete req.run;
+    }
+}
+
+bool AnalysisKey::operator==(const AnalysisKey& rhs) const
+{
+    return session == rhs.session && begin == rhs.begin && end == rhs.end &&
+        mask == rhs.mask && raw_ra == rhs.raw_ra &&
+        opts.mode == rhs.opts.mode &&
+        (opts.mode != SPECTRUM_WELCH || (opts.segment == rhs.opts.segment && opts.overlap == rhs.opts.overlap));
+}
+
+// Completed analyses, most recently used first. Only used on the UI
+// thread. Shared by all analysis windows so it outlives the window.
+class AnalysisCache
+{
+    enum { MAX_BYTES = 256 * 1024 * 1024 };
+
+    struct Entry
+    {
+        AnalysisKey key;
+        GARun *run;
+        size_t bytes;
+    };
+    std::list<Entry> m_entries;
+    size_t m_bytes;
+
+public:
+    AnalysisCache() : m_bytes(0) { }
+    ~AnalysisCache() { Clear(); }
+    const GARun *Find(const AnalysisKey& key);
+    void Add(const AnalysisKey& key, const GARun& run);
+    void Clear();
+};
+
+static AnalysisCache s_cache;
+
+const GARun *AnalysisCache::Find(const AnalysisKey& key)
+{
+    for (auto it = m_entries.begin(); it != m_entries.end(); ++it)
+    {
+        if (it->key == key)
+        {
+            m_entries.splice(m_entries.begin(), m_entries, it);
+            return m_entries.front().run;
+        }
+    }
+    return nullptr;
+}
+
+void AnalysisCache::Add(const AnalysisKey& key, const GARun& run)
+{
+    if (Find(key))
+        return;
+
+    size_t bytes = run.MemSize();
+    if (bytes > MAX_BYTES)
+        return;
+
+    // make room first so the copy can reuse an evicted entry's buffers
+    GARun *spare = nullptr;
+    while (!m_entries.empty() && m_bytes + bytes > MAX_BYTES)
+    {
+        m_bytes -= m_entries.back().bytes;
+        delete spare;
+        spare = m_entries.back().run;
+        m_entries.pop_back();
+    }
+
+    Entry e;
+    e.key = key;
+    e.run = spare ? spare : new GARun();
+    e.run->CopyFrom(run);
+    e.bytes = e.run->MemSize();
+
+    m_entries.push_front(e);
+    m_bytes += e.bytes;
+
+    // the reused buffers may have been bigger than the estimate
+    while (m_entries.size() > 1 && m_bytes > MAX_BYTES)
+    {
+        m_bytes -= m_entries.back().bytes;
+        delete m_entries.back().run;
+        m_entries.pop_back();
+    }
+}
+
+void AnalysisCache::Clear()
+{
+    for (auto it = m_entries.begin(); it != m_entries.end(); ++it)
+        delete it->run;
+    m_entries.clear();
+    m_bytes = 0;
+}
+
+void AnalysisWin::ClearCache()
+{
+    s_cache.Clear();
+}
+
+// FNV-1a hash of the include flags
+static unsigned long long IncludeMask(const GuideSession& session, size_t begin, size_t end)
+{
+    unsigned long long h = 14695981039346656037ULL;
+    for (size_t i = begin; i < end; i++)
+    {
+        h ^= Include(session.entries[i]) ? 1 : 0;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
 wxBEGIN_EVENT_TABLE(AnalysisWin, AnalyzeFrameBase)
   EVT_MOUSEWHEEL(AnalysisWin::OnMouseWheel)
 wxEND_EVENT_TABLE()
@@ -618,20 +998,38 @@ wxEND_EVENT_TABLE()
 AnalysisWin::AnalysisWin(LogViewFrame *parent)
     :
     AnalyzeFrameBase(parent),
-    m_cursor(-1)
+    m_cursor(-1),
+    m_spare(nullptr)
 {
     m_graph->SetBackgroundStyle(wxBG_STYLE_PAINT);
     LoadGeometry(this, "/geometry.awin");
 
     m_graph->Connect(wxEVT_MOUSE_CAPTURE_LOST, wxMouseCaptureLostEventHandler(AnalysisWin::OnCaptureLost), nullptr, this);
+    Bind(wxEVT_CHAR_HOOK, &AnalysisWin::OnKeyDown, this);
+
+    m_worker = new AnalysisWorker(this);
 }
 
 AnalysisWin::~AnalysisWin()
 {
+    // stop the worker before the window goes away; any results it has
+    // already posted are discarded along with the window's pending events
+    delete m_worker;
+    delete m_spare;
+
     LogViewFrame *win = static_cast<LogViewFrame *>(GetParent());
     win->m_analysisWin = nullptr;
 }
 
+static SpectrumOptions GetSpectrumOptions(const AnalysisWin *aw)
+{
+    SpectrumOptions opts;
+    opts.mode = (SpectrumMode) aw->m_spectrum->GetSelection();
+    opts.segment = s_settings.welch.segment;
+    opts.overlap = s_settings.welch.overlap;
+    return opts;
+}
+
 static void GetGABounds(const GuideSession& session, size_t pos, size_t *begin, size_t *end)
 {
     const auto& entries = session.entries;
@@ -667,14 +1065,48 @@ bool AnalysisWin::CanAnalyzeGA(const GuideSession& session, size_t pos)
     return GARun::CanAnalyze(session, begin, end);
 }
 
+GARun *AnalysisWin::TakeSpare()
+{
+    GARun *run = m_spare ? m_spare : new GARun();
+    m_spare = nullptr;
+    return run;
+}
+
+void AnalysisWin::Submit(GARun *run, const AnalysisKey& key)
+{
+    m_worker->Submit(run, key);
+    m_statusBar->SetStatusText(_("Analyzing..."));
+}
+
+void AnalysisWin::Analyze(const GuideSession& session, size_t begin, size_t end, bool undo_ra_corrections)
+{
+    AnalysisKey key;
+    key.session = &session;
+    key.begin = begin;
+    key.end = end;
+    key.mask = IncludeMask(session, begin, end);
+    key.raw_ra = undo_ra_corrections;
+    key.opts = GetSpectrumOptions(this);
+
+    const GARun *cached = s_cache.Find(key);
+    if (cached)
+    {
+        m_worker->Cancel();
+        m_garun.CopyFrom(*cached);
+        ShowResult(key);
+        return;
+    }
+
+    GARun *run = TakeSpare();
+    run->Load(session, begin, end, undo_ra_corrections);
+    Submit(run, key);
+}
+
 void AnalysisWin::AnalyzeGA(const GuideSession& session, size_t pos)
 {
     size_t begin, end;
     GetGABounds(session, pos, &begin, &end);
-    m_garun.Analyze(session, begin, end, false);
-    s_drpos.Init(m_graph->GetSize(), m_garun);
-    s_fftpos.Init(m_graph->GetSize(), m_garun);
-    SetTitle(_("Analysis"));
+    Analyze(session, begin, end, false);
 }
 
 bool AnalysisWin::CanAnalyzeAll(const GuideSession& session)
@@ -684,14 +1116,90 @@ bool AnalysisWin::CanAnalyzeAll(const GuideSession& session)
 
 void AnalysisWin::AnalyzeAll(const GuideSession& session, bool undo_ra_corrections)
 {
-    m_garun.Analyze(session, 0, session.entries.size(), undo_ra_corrections);
+    Analyze(session, 0, session.entries.size(), undo_ra_corrections);
+}
+
+void AnalysisWin::OnAnalysisProgress(int percent)
+{
+    m_statusBar->SetStatusText(wxString::Format(_("Analyzing... %d%%"), percent));
+}
+
+void AnalysisWin::OnAnalysisDone()
+{
+    AnalysisKey key;
+    bool sgram;
+    GARun *run = m_worker->TakeResult(&key, &sgram);
+    if (!run)
+        return;
+
+    if (sgram)
+    {
+        // the spectrogram of a result that may have been replaced since
+        key.opts = m_key.opts;
+        if (key == m_key && HaveData())
+            m_garun.sgram.Swap(run->sgram);
+        delete m_spare;
+        m_spare = run;
+        m_statusBar->SetStatusText(wxEmptyString);
+        m_graph->Refresh();
+        // the Welch settings may have changed while it was computed
+        RequestSpectrogram();
+        return;
+    }
+
+    m_garun.Swap(*run);
+    delete m_spare;
+    m_spare = run;
+
+    s_cache.Add(key, m_garun);
+    ShowResult(key);
+}
+
+// whether the spectrogram was computed with the current Welch settings
+static bool SpectrogramCurrent(const Spectrogram& sg)
+{
+    return sg.valid && sg.segment == s_settings.welch.segment && sg.overlap == s_settings.welch.overlap;
+}
+
+void AnalysisWin::RequestSpectrogram()
+{
+    if (!m_toggleSpectrogram->GetValue() || !HaveData() || SpectrogramCurrent(m_garun.sgram))
+        return;
+
+    // asked again when the analysis under way is done
+    if (m_worker->Busy())
+        return;
+
+    AnalysisKey key = m_key;
+    key.opts.segment = s_settings.welch.segment;
+    key.opts.overlap = s_settings.welch.overlap;
+
+    GARun *run = TakeSpare();
+    run->CopyFrom(m_garun);
+    m_worker->Submit(run, key, true);
+    m_statusBar->SetStatusText(_("Computing the spectrogram..."));
+}
+
+void AnalysisWin::ShowResult(const AnalysisKey& key)
+{
+    m_key = key;
     s_drpos.Init(m_graph->GetSize(), m_garun);
     s_fftpos.Init(m_graph->GetSize(), m_garun);
-    SetTitle(undo_ra_corrections ? _("Analysis ** RA Corrections Removed **") : _("Analysis"));
+    m_cursor = -1;
+    SetTitle(key.raw_ra ? _("Analysis ** RA Corrections Removed **") : _("Analysis"));
+    m_statusBar->SetStatusText(wxEmptyString);
+    m_graph->Refresh();
+    RequestSpectrogram();
 }
 
 void AnalysisWin::OnCheck(wxCommandEvent& event)
 {
+    if (m_toggleFFT->GetValue())
+    {
+        // the cursor may have been on the curve that was hidden
+        m_cursor = -1;
+        m_statusBar->SetStatusText(wxEmptyString);
+    }
     m_graph->Refresh();
 }
 
@@ -703,6 +1211,9 @@ void AnalysisWin::OnClose(wxCloseEvent& event)
 
 void AnalysisWin::OnSizeGraph(wxSizeEvent& event)
 {
+    if (!HaveData())
+        return;
+
     s_drpos.Resize(m_graph->GetSize());
     s_fftpos.Resize(m_graph->GetSize());
     m_cursor = -1;
@@ -722,6 +1233,7 @@ void AnalysisWin::OnBtnLeftDown(wxMouseEvent& event)
 void AnalysisWin::OnClickDrift(wxCommandEvent& event)
 {
     m_toggleFFT->SetValue(false);
+    m_toggleSpectrogram->SetValue(false);
     m_graph->Refresh();
     m_ra->Show();
     m_dec->Show();
@@ -732,15 +1244,66 @@ void AnalysisWin::OnClickDrift(wxCommandEvent& event)
 void AnalysisWin::OnClickFFT(wxCommandEvent& event)
 {
     m_toggleDrift->SetValue(false);
+    m_toggleSpectrogram->SetValue(false);
+    m_graph->Refresh();
+    m_ra->Show();
+    m_dec->Show();
+    m_statusBar->SetStatusText(wxEmptyString);
+    Layout(); // in case size changed
+}
+
+void AnalysisWin::OnClickSpectrogram(wxCommandEvent& event)
+{
+    m_toggleDrift->SetValue(false);
+    m_toggleFFT->SetValue(false);
     m_graph->Refresh();
-    m_ra->Hide();
-    m_dec->Hide();
+    m_ra->Show();
+    m_dec->Show();
     m_statusBar->SetStatusText(wxEmptyString);
+    Layout(); // in case size changed
+    RequestSpectrogram();
+}
+
+// the cursor follows the RA spectrum unless only Dec is shown
+static bool CursorOnDec(const AnalysisWin *aw)
+{
+    return aw->m_dec->GetValue() && !aw->m_ra->GetValue();
+}
+
+// likewise the spectrogram shows RA unless only Dec is checked
+static bool SpectrogramOnDec(const AnalysisWin *aw)
+{
+    return CursorOnDec(aw);
+}
+
+void AnalysisWin::OnSpectrum(wxCommandEvent& event)
+{
+    // an analysis in progress picks up the new mode
+    if (m_worker->Respectrum(GetSpectrumOptions(this)))
+        return;
+
+    if (!HaveData())
+        return;
+
+    AnalysisKey key = m_key;
+    key.opts = GetSpectrumOptions(this);
+
+    const GARun *cached = s_cache.Find(key);
+    if (cached)
+    {
+        m_garun.CopyFrom(*cached);
+        ShowResult(key);
+        return;
+    }
+
+    GARun *run = TakeSpare();
+    run->LoadFrom(m_garun);
+    Submit(run, key);
 }
 
 static void HZoom(AnalysisWin *aw, double f, int center)
 {
-    if (aw->m_toggleDrift->GetValue())
+    if (!aw->m_toggleFFT->GetValue())
         s_drpos.HZoom(f, center);
     else
     {
@@ -838,7 +1401,9 @@ void AnalysisWin::OnMove(wxMouseEvent& event)
         }
         if (dy != 0)
         {
-            if (m_toggleFFT->GetValue())
+            if (m_toggleSpectrogram->GetValue())
+                s_sgview.SetGain(s_sgview.gain * (dy < 0 ? 1.05 : 1.0 / 1.05));
+            else if (m_toggleFFT->GetValue())
                 s_fftpos.VZoom(dy < 0 ? 1.05 : 1.0 / 1.05);
             else
                 s_drpos.VZoom(dy < 0 ? 1.05 : 1.0 / 1.05);
@@ -850,6 +1415,9 @@ void AnalysisWin::OnMove(wxMouseEvent& event)
 
     // not dragging
 
+    if (!HaveData())
+        return;
+
     int x = event.GetPosition().x;
 
     if (m_toggleFFT->GetValue())
@@ -860,6 +1428,8 @@ void AnalysisWin::OnMove(wxMouseEvent& event)
             return;
         }
 
+        bool const dec = CursorOnDec(this);
+
         // find closest maximum within several pixels
         {
             enum { DIST = 8 };
@@ -871,9 +1441,9 @@ void AnalysisWin::OnMove(wxMouseEvent& event)
             {
                 if (xl - 1 < s_fftpos.StartX() || xl + 1 >= s_fftpos.EndX())
                     break;
-                double a1 = s_fftpos.FEval(xl - 1);
-                double a2 = s_fftpos.FEval(xl);
-                double a3 = s_fftpos.FEval(xl + 1);
+                double a1 = s_fftpos.FEval(xl - 1, dec);
+                double a2 = s_fftpos.FEval(xl, dec);
+                double a3 = s_fftpos.FEval(xl + 1, dec);
                 if (a2 > a1 && a2 > a3)
                 {
                     foundl = true;
@@ -887,9 +1457,9 @@ void AnalysisWin::OnMove(wxMouseEvent& event)
             {
                 if (xr - 1 < s_fftpos.StartX() || xr + 1 >= s_fftpos.EndX())
                     break;
-                double a1 = s_fftpos.FEval(xr - 1);
-                double a2 = s_fftpos.FEval(xr);
-                double a3 = s_fftpos.FEval(xr + 1);
+                double a1 = s_fftpos.FEval(xr - 1, dec);
+                double a2 = s_fftpos.FEval(xr, dec);
+                double a3 = s_fftpos.FEval(xr + 1, dec);
                 if (a2 > a1 && a2 > a3)
                 {
                     foundr = true;
@@ -909,21 +1479,37 @@ void AnalysisWin::OnMove(wxMouseEvent& event)
 
         m_graph->Refresh();
 
-        int y;
-        double p, a;
-        s_fftpos.Eval(m_cursor, &y, &p, &a);
+        double p = s_fftpos.P(m_cursor);
+        double a = s_fftpos.FEval(m_cursor, dec);
+        double other = s_fftpos.FEval(m_cursor, !dec);
 
-        m_statusBar->SetStatusText(wxString::Format("Period: %.1fs  Amplitude: %.1f\" (%.2fpx)  P-P: %.1f\" (%.2fpx)  RMS: %.1f\" (%.2fpx)",
-            p, a * m_garun.pixscale, a, 2. * a * m_garun.pixscale, 2. * a,
-            M_SQRT2 / 2.0 * a * m_garun.pixscale, M_SQRT2 / 2.0 * a));
+        m_statusBar->SetStatusText(wxString::Format("Period: %.1fs  %s Amplitude: %.1f\" (%.2fpx)  P-P: %.1f\" (%.2fpx)  RMS: %.1f\" (%.2fpx)  %s: %.1f\" (%.2fpx)",
+            p, dec ? "Dec" : "RA", a * m_garun.pixscale, a, 2. * a * m_garun.pixscale, 2. * a,
+            M_SQRT2 / 2.0 * a * m_garun.pixscale, M_SQRT2 / 2.0 * a,
+            dec ? "RA" : "Dec", other * m_garun.pixscale, other));
     }
     else
     {
         wxString s;
         double const t = s_drpos.T(x);
-        if (m_garun.len >= 2 && t >= m_garun.t[0] && t <= m_garun.t[m_garun.len - 1])
+        int const y = event.GetPosition().y;
+        const Spectrogram& sg = m_garun.sgram;
+        if (m_toggleSpectrogram->GetValue())
+        {
+            int const w = sg.valid && sg.nwin ? SgramView::Window(sg, m_garun, t) : -1;
+            int const h = s_drpos.y0 - s_drpos.y1;
+            if (w >= 0 && y >= s_drpos.y1 && y < s_drpos.y0)
+            {
+                bool const dec = SpectrogramOnDec(this);
+                double const p = SgramView::Period(sg, h, y - s_drpos.y1);
+                double const a = sg.amp[dec ? 1 : 0][w * sg.nf + SgramView::Bin(sg, p)];
+                s = wxString::Format("Time: %-.1fs  %s    Period: %.1fs  %s Amplitude: %.1f\" (%.2fpx)",
+                        t, (m_garun.starts + wxTimeSpan(0, 0, t)).Format("%H:%M:%S"),
+                        p, dec ? "Dec" : "RA", a * m_garun.pixscale, a);
+            }
+        }
+        else if (m_garun.len >= 2 && t >= m_garun.t[0] && t <= m_garun.t[m_garun.len - 1])
         {
-            int y = event.GetPosition().y;
             double yval = s_drpos.RaOrDec(y);
             s = wxString::Format("Time: %-.1fs  %s    Y: %.2f\" (%.2fpx)",
                     t, (m_garun.starts + wxTimeSpan(0, 0, t)).Format("%H:%M:%S"),
@@ -933,46 +1519,62 @@ void AnalysisWin::OnMove(wxMouseEvent& event)
     }
 }
 
-static void PaintDrift(AnalysisWin *aw, const GARun& ga, wxDC& dc)
+// What the drift and spectrum plots show and where; taken from the window,
+// or set up by PaintAnalysisPlot for an export
+struct PlotView
+{
+    DriftPos *drpos;
+    FFTPos *fftpos;
+    int height;
+    bool ra, dec;
+    bool arcsecs;
+    int cursor;     // spectrum cursor x, -1 for none
+    PaintProfile *profile;
+};
+
+// time divisions, shared by the drift graph and the spectrogram
+static void PaintTimeGrid(DriftPos& pos, wxDC& dc)
+{
+    enum { MINSEP = 40 };
+    dc.SetTextForeground(*wxLIGHT_GREY);
+#if defined(__WXOSX__)
+    dc.SetFont(wxSMALL_FONT->Smaller());
+#else
+    dc.SetFont(wxSWISS_FONT->Smaller());
+#endif
+    dc.SetPen(wxPen(wxColour(80, 80, 80), 1, wxPENSTYLE_DOT));
+    double const dt = pos.T(MINSEP) - pos.T(0);
+    double const incr = pow(10.0, ceil(log10(dt)));
+    double const start = ceil(pos.T(pos.x0) / incr) * incr;
+    double const end = floor(pos.T(pos.x1) / incr) * incr;
+    for (double t = start; t <= end; t += incr)
+    {
+        int x = pos.X(t);
+        dc.DrawLine(x, pos.y0, x, pos.y1);
+        dc.DrawText(wxString::Format("%g", t), x + 2, pos.y1 + 1);
+    }
+}
+
+static void PaintDrift(const PlotView& view, const GARun& ga, wxDC& dc)
 {
-    const wxSize& sz = aw->m_graph->GetSize();
+    DriftPos& drpos = *view.drpos;
 
     // axes
     dc.SetPen(*wxGREY_PEN);
 
     // x-axis
-    int const ymid = (s_drpos.y0 + s_drpos.y1) / 2;
-    dc.DrawLine(s_drpos.x0, ymid, s_drpos.x1, ymid);
+    int const ymid = (drpos.y0 + drpos.y1) / 2;
+    dc.DrawLine(drpos.x0, ymid, drpos.x1, ymid);
 
-    // time divisions
-    {
-        enum { MINSEP = 40 };
-        dc.SetTextForeground(*wxLIGHT_GREY);
-#if defined(__WXOSX__)
-        dc.SetFont(wxSMALL_FONT->Smaller());
-#else
-        dc.SetFont(wxSWISS_FONT->Smaller());
-#endif
-        dc.SetPen(wxPen(wxColour(80, 80, 80), 1, wxPENSTYLE_DOT));
-        double const dt = s_drpos.T(MINSEP) - s_drpos.T(0);
-        double const incr = pow(10.0, ceil(log10(dt)));
-        double const start = ceil(s_drpos.T(s_drpos.x0) / incr) * incr;
-        double const end = floor(s_drpos.T(s_drpos.x1) / incr) * incr;
-        for (double t = start; t <= end; t += incr)
-        {
-            int x = s_drpos.X(t);
-            dc.DrawLine(x, s_drpos.y0, x, s_drpos.y1);
-            dc.DrawText(wxString::Format("%g", t), x + 2, s_drpos.y1 + 1);
-        }
-    }
+    PaintTimeGrid(drpos, dc);
 
     {
         // horizontal grid lines
-        double vsc = s_drpos.scy;
-        bool const arcsecs = wxGetApp().LVFrame()->ArcsecsSelected();
+        double vsc = drpos.scy;
+        bool const arcsecs = view.arcsecs;
         if (arcsecs) // arc-seconds
             vsc /= ga.pixscale;
-        double v = (double) sz.GetHeight() * (0.5 / 6.0) / vsc;
+        double v = (double) view.height * (0.5 / 6.0) / vsc;
         double m = pow(10, ceil(log10(v)));
         double t;
         if (v < (t = .25 * m))
@@ -985,19 +1587,19 @@ static void PaintDrift(AnalysisWin *aw, const GARun& ga, wxDC& dc)
 
         if (iv > 0)
         {
-            int const y0 = (s_drpos.y0 + s_drpos.y1) / 2;
-            int const x0 = s_drpos.x0;
-            int const x1 = s_drpos.x1;
+            int const y0 = (drpos.y0 + drpos.y1) / 2;
+            int const x0 = drpos.x0;
+            int const x1 = drpos.x1;
             dc.SetPen(wxPen(wxColour(60, 60, 60), 1, wxPENSTYLE_DOT));
             double dy = v;
             wxString format = arcsecs ? "%g\"" : "%g";
-            for (int y = y0 - iv; y > s_drpos.y1; y -= iv, dy += v)
+            for (int y = y0 - iv; y > drpos.y1; y -= iv, dy += v)
             {
                 dc.DrawLine(x0, y, x1, y);
                 dc.DrawText(wxString::Format(format, dy), 3, y + 2);
             }
             dy = -v;
-            for (int y = y0 + iv; y < s_drpos.y0; y += iv, dy -= v)
+            for (int y = y0 + iv; y < drpos.y0; y += iv, dy -= v)
             {
                 dc.DrawLine(x0, y, x1, y);
                 dc.DrawText(wxString::Format(format, dy), 3, y + 2);
@@ -1005,8 +1607,10 @@ static void PaintDrift(AnalysisWin *aw, const GARun& ga, wxDC& dc)
         }
     }
 
+    view.profile->Mark("grid");
+
     size_t n = ga.len;
-    bool plot_ra = aw->m_ra->GetValue(), plot_dec = aw->m_dec->GetValue();
+    bool plot_ra = view.ra, plot_dec = view.dec;
     if (n < 2 || !(plot_ra || plot_dec))
         return;
 
@@ -1014,7 +1618,7 @@ static void PaintDrift(AnalysisWin *aw, const GARun& ga, wxDC& dc)
 
     size_t i0 = 0;
     {
-        double const tx0 = s_drpos.T(s_drpos.x0);
+        double const tx0 = drpos.T(drpos.x0);
         if (tx0 > ga.t[0])
         {
             for (; i0 < n - 1; ++i0)
@@ -1025,7 +1629,7 @@ static void PaintDrift(AnalysisWin *aw, const GARun& ga, wxDC& dc)
 
     size_t i1 = n - 1;
     {
-        double const tx1 = s_drpos.T(s_drpos.x1);
+        double const tx1 = drpos.T(drpos.x1);
         if (tx1 < ga.t[n - 1])
         {
             for (; i1 >= 1; --i1)
@@ -1041,25 +1645,29 @@ static void PaintDrift(AnalysisWin *aw, const GARun& ga, wxDC& dc)
 
     int np = 0;
     for (size_t i = i0; i <= i1; i++)
-        s_tmp.pts[np++].x = (int) (s_drpos.xofs + ga.t[i] / s_drpos.scx);
+        s_tmp.pts[np++].x = (int) (drpos.xofs + ga.t[i] / drpos.scx);
 
     if (plot_ra)
     {
         np = 0;
         for (size_t i = i0; i <= i1; i++)
-            s_tmp.pts[np++].y = ymid + (int) (ga.rac[i] * s_drpos.scy);
+            s_tmp.pts[np++].y = ymid + (int) (ga.rac[i] * drpos.scy);
         dc.SetPen(wxPen(s_settings.raColor, 2));
         dc.DrawLines(np, s_tmp.pts);
+        view.profile->AddPoints(np);
     }
 
     if (plot_dec)
     {
         np = 0;
         for (size_t i = i0; i <= i1; i++)
-            s_tmp.pts[np++].y = ymid - (int) (ga.decc[i] * s_drpos.scy);
+            s_tmp.pts[np++].y = ymid - (int) (ga.decc[i] * drpos.scy);
         dc.SetPen(wxPen(s_settings.decColor, 2));
         dc.DrawLines(np, s_tmp.pts);
+        view.profile->AddPoints(np);
     }
+
+    view.profile->Mark("curves");
 }
 
 static double IncrP(double p)
@@ -1073,8 +1681,11 @@ static double StartP(double p)
     return ceil(p / incr) * incr;
 }
 
-static void PaintFFT(AnalysisWin *aw, const GARun& ga, wxDC& dc)
+static void PaintFFT(const PlotView& view, const GARun& ga, wxDC& dc)
 {
+    DriftPos& drpos = *view.drpos;
+    FFTPos& fftpos = *view.fftpos;
+
     // x grid
     {
         dc.SetTextForeground(*wxLIGHT_GREY);
@@ -1084,24 +1695,24 @@ static void PaintFFT(AnalysisWin *aw, const GARun& ga, wxDC& dc)
         dc.SetFont(wxSWISS_FONT->Smaller());
 #endif
         dc.SetPen(wxPen(wxColour(60, 60, 60), 1, wxPENSTYLE_SOLID));
-        double p0 = s_fftpos.P(s_fftpos.x0);
-        double p1 = s_fftpos.P(s_fftpos.x1);
+        double p0 = fftpos.P(fftpos.x0);
+        double p1 = fftpos.P(fftpos.x1);
         for (double p = StartP(p0); p < p1; p += IncrP(p))
         {
-            int x = s_fftpos.X(p);
-            dc.DrawLine(x, s_fftpos.y0, x, s_fftpos.y1);
-            dc.DrawText(wxString::Format("%g", p), x + 2, s_fftpos.y1 + 1);
+            int x = fftpos.X(p);
+            dc.DrawLine(x, fftpos.y0, x, fftpos.y1);
+            dc.DrawText(wxString::Format("%g", p), x + 2, fftpos.y1 + 1);
         }
-        dc.DrawLine(s_fftpos.x0, s_fftpos.y0, s_fftpos.x1, s_fftpos.y0);
+        dc.DrawLine(fftpos.x0, fftpos.y0, fftpos.x1, fftpos.y0);
     }
 
     {
         // horizontal grid lines
-        double vsc = s_fftpos.scy;
-        bool const arcsecs = wxGetApp().LVFrame()->ArcsecsSelected();
+        double vsc = fftpos.scy;
+        bool const arcsecs = view.arcsecs;
         if (arcsecs) // arc-seconds
             vsc /= ga.pixscale;
-        double v = (double) aw->m_graph->GetSize().GetHeight() * (0.5 / 6.0) / vsc;
+        double v = (double) view.height * (0.5 / 6.0) / vsc;
         double m = pow(10, ceil(log10(v)));
         double t;
         if (v < (t = .25 * m))
@@ -1114,13 +1725,13 @@ static void PaintFFT(AnalysisWin *aw, const GARun& ga, wxDC& dc)
 
         if (iv > 0)
         {
-            int const y0 = s_drpos.y0;
-            int const x0 = s_drpos.x0;
-            int const x1 = s_drpos.x1;
+            int const y0 = drpos.y0;
+            int const x0 = drpos.x0;
+            int const x1 = drpos.x1;
             dc.SetPen(wxPen(wxColour(60, 60, 60), 1, wxPENSTYLE_DOT));
             double dy = v;
             wxString format = arcsecs ? "%g\"" : "%g";
-            for (int y = y0 - iv; y > s_drpos.y1; y -= iv, dy += v)
+            for (int y = y0 - iv; y > drpos.y1; y -= iv, dy += v)
             {
                 dc.DrawLine(x0, y, x1, y);
                 dc.DrawText(wxString::Format(format, dy), 3, y + 2);
@@ -1128,39 +1739,205 @@ static void PaintFFT(AnalysisWin *aw, const GARun& ga, wxDC& dc)
         }
     }
 
+    view.profile->Mark("grid");
+
     int const dx = 1;
-    int nx = (s_fftpos.x1 - s_fftpos.x0 + dx - 1) / dx + 1;
+    int nx = (fftpos.x1 - fftpos.x0 + dx - 1) / dx + 1;
     s_tmp.alloc(nx);
 
-    int i = 0;
-    for (int x = s_fftpos.StartX(); x < s_fftpos.EndX(); x += dx, ++i)
+    // Dec first so RA is drawn on top
+    for (int pass = 0; pass < 2; pass++)
     {
-        s_tmp.pts[i].x = x;
-        s_tmp.pts[i].y = s_fftpos.Eval(x);
+        bool const dec = pass == 0;
+        if (!(dec ? view.dec : view.ra))
+            continue;
+
+        int i = 0;
+        for (int x = fftpos.StartX(); x < fftpos.EndX(); x += dx, ++i)
+        {
+            s_tmp.pts[i].x = x;
+            s_tmp.pts[i].y = fftpos.Eval(x, dec);
+        }
+
+        dc.SetPen(wxPen(dec ? s_settings.decColor : s_settings.raColor, 2));
+        dc.DrawLines(i, s_tmp.pts);
+        view.profile->AddPoints(i);
     }
 
-    dc.SetPen(wxPen(s_settings.raColor, 2));
-    dc.DrawLines(i, s_tmp.pts);
+    view.profile->Mark("curves");
 
-    if (aw->m_cursor >= 0)
+    if (view.cursor >= 0)
     {
         wxPen YellowDashPen(wxColour(140, 140, 0), 1, wxPENSTYLE_DOT);
         dc.SetPen(YellowDashPen);
-        dc.DrawLine(aw->m_cursor, s_fftpos.y0, aw->m_cursor, s_fftpos.y1);
-        int y = s_fftpos.Eval(aw->m_cursor);
+        dc.DrawLine(view.cursor, fftpos.y0, view.cursor, fftpos.y1);
+        int y = fftpos.Eval(view.cursor, view.dec && !view.ra);
         dc.SetBrush(*wxWHITE);
-        dc.DrawCircle(aw->m_cursor, y, 4);
+        dc.DrawCircle(view.cursor, y, 4);
     }
 }
 
+static void PaintSpectrogram(AnalysisWin *aw, const GARun& ga, wxDC& dc)
+{
+    const Spectrogram& sg = ga.sgram;
+
+    dc.SetTextForeground(*wxLIGHT_GREY);
+#if defined(__WXOSX__)
+    dc.SetFont(wxSMALL_FONT->Smaller());
+#else
+    dc.SetFont(wxSWISS_FONT->Smaller());
+#endif
+
+    // requested from the worker when the view or the settings change
+    if (!SpectrogramCurrent(sg))
+    {
+        dc.DrawText(_("Computing the spectrogram..."), s_drpos.x0, s_drpos.y1);
+        return;
+    }
+
+    if (sg.nwin == 0)
+    {
+        dc.DrawText(_("The analysis is shorter than the Welch segment length"), s_drpos.x0, s_drpos.y1);
+        return;
+    }
+
+    int const x0 = s_drpos.x0;
+    int const y1 = s_drpos.y1;
+    int const w = s_drpos.x1 - x0;
+    int const h = s_drpos.y0 - y1;
+    if (w <= 0 || h <= 0)
+        return;
+
+    s_sgview.Update(sg, SpectrogramOnDec(aw) ? 1 : 0, h);
+
+    std::vector<int>& col = s_sgview.col;
+    col.resize(w);
+    for (int x = 0; x < w; x++)
+        col[x] = SgramView::Window(sg, ga, s_drpos.T(x0 + x));
+
+    wxImage& img = s_sgview.img;
+    if (!img.IsOk() || img.GetWidth() != w || img.GetHeight() != h)
+        img.Create(w, h, false);
+
+    size_t const nwin = sg.nwin;
+    unsigned char *dst = img.GetData();
+    for (int r = 0; r < h; r++)
+    {
+        const unsigned char *src = &s_sgview.rgb[(size_t) r * nwin * 3];
+        for (int x = 0; x < w; x++, dst += 3)
+        {
+            int const c = col[x];
+            if (c < 0)
+                dst[0] = dst[1] = dst[2] = 0;
+            else
+            {
+                const unsigned char *px = src + 3 * c;
+                dst[0] = px[0];
+                dst[1] = px[1];
+                dst[2] = px[2];
+            }
+        }
+    }
+
+    dc.DrawBitmap(wxBitmap(img), x0, y1);
+    aw->m_profile.AddPoints((unsigned int) w * h);
+    aw->m_profile.Mark("image");
+
+    PaintTimeGrid(s_drpos, dc);
+
+    // period grid
+    dc.SetPen(wxPen(wxColour(80, 80, 80), 1, wxPENSTYLE_DOT));
+    double const plo = SgramView::Period(sg, h, h - 1);
+    double const phi = SgramView::Period(sg, h, 0);
+    int prev = -1000;
+    for (double p = StartP(plo); p < phi; p += IncrP(p))
+    {
+        int y = y1 + (int) SgramView::Row(sg, h, p);
+        if (abs(y - prev) < 15)
+            continue;
+        prev = y;
+        dc.DrawLine(x0, y, x0 + w, y);
+        dc.DrawText(wxString::Format("%gs", p), 3, y + 2);
+    }
+
+    aw->m_profile.Mark("grid");
+}
+
 void AnalysisWin::OnPaintGraph(wxPaintEvent& event)
 {
     wxAutoBufferedPaintDC dc(m_graph);
     dc.Clear();
+    if (!HaveData())
+        return;
+
+    PlotView view;
+    view.drpos = &s_drpos;
+    view.fftpos = &s_fftpos;
+    view.height = m_graph->GetSize().GetHeight();
+    view.ra = m_ra->GetValue();
+    view.dec = m_dec->GetValue();
+    view.arcsecs = wxGetApp().LVFrame()->ArcsecsSelected();
+    view.cursor = m_cursor;
+    view.profile = &m_profile;
+
+    m_profile.Begin();
     if (m_toggleDrift->GetValue())
-        PaintDrift(this, m_garun, dc);
+        PaintDrift(view, m_garun, dc);
+    else if (m_toggleSpectrogram->GetValue())
+        PaintSpectrogram(this, m_garun, dc);
     else
-        PaintFFT(this, m_garun, dc);
+        PaintFFT(view, m_garun, dc);
+    m_profile.End();
+
+    if (m_profile.IsShown())
+        m_profile.Draw(dc);
+}
+
+void PaintAnalysisPlot(wxDC& dc, const wxSize& size, const GARun& ga, bool fft, bool arcsecs)
+{
+    // positions of its own, leaving those of the window alone
+    DriftPos drpos;
+    FFTPos fftpos;
+    drpos.Init(size, ga);
+    fftpos.Init(size, ga);
+    PaintProfile profile;
+
+    PlotView view;
+    view.drpos = &drpos;
+    view.fftpos = &fftpos;
+    view.height = size.GetHeight();
+    view.ra = view.dec = true;
+    view.arcsecs = arcsecs;
+    view.cursor = -1;
+    view.profile = &profile;
+
+    if (fft)
+        PaintFFT(view, ga, dc);
+    else
+        PaintDrift(view, ga, dc);
+}
+
+void AnalysisWin::OnKeyDown(wxKeyEvent& event)
+{
+    if (event.GetKeyCode() != WXK_F3)
+    {
+        event.Skip();
+        return;
+    }
+
+    if (event.ShiftDown())
+    {
+        if (wxClipboard::Get()->Open())
+        {
+            wxClipboard::Get()->SetData(new wxTextDataObject(m_profile.Report()));
+            wxClipboard::Get()->Close();
+        }
+    }
+    else
+    {
+        m_profile.Toggle();
+        m_graph->Refresh();
+    }
 }
 
 void AnalysisWin::OnHMinus(wxCommandEvent& event)
@@ -1175,6 +1952,9 @@ void AnalysisWin::OnHPlus(wxCommandEvent& event)
 
 void AnalysisWin::OnHReset(wxCommandEvent& event)
 {
+    if (!HaveData())
+        return;
+
     if (m_toggleFFT->GetValue())
     {
         s_fftpos.HReset(m_graph->GetSize().x);
@@ -1188,7 +1968,9 @@ void AnalysisWin::OnHReset(wxCommandEvent& event)
 
 void AnalysisWin::OnVMinus(wxCommandEvent& event)
 {
-    if (m_toggleFFT->GetValue())
+    if (m_toggleSpectrogram->GetValue())
+        s_sgview.SetGain(s_sgview.gain / 1.1);
+    else if (m_toggleFFT->GetValue())
         s_fftpos.VZoom(1.0 / 1.1);
     else
         s_drpos.VZoom(1.0 / 1.1);
@@ -1198,7 +1980,9 @@ void AnalysisWin::OnVMinus(wxCommandEvent& event)
 
 void AnalysisWin::OnVPlus(wxCommandEvent& event)
 {
-    if (m_toggleFFT->GetValue())
+    if (m_toggleSpectrogram->GetValue())
+        s_sgview.SetGain(s_sgview.gain * 1.1);
+    else if (m_toggleFFT->GetValue())
         s_fftpos.VZoom(1.1);
     else
         s_drpos.VZoom(1.1);
@@ -1208,7 +1992,12 @@ void AnalysisWin::OnVPlus(wxCommandEvent& event)
 
 void AnalysisWin::OnVReset(wxCommandEvent& event)
 {
-    if (m_toggleFFT->GetValue())
+    if (!HaveData())
+        return;
+
+    if (m_toggleSpectrogram->GetValue())
+        s_sgview.SetGain(1.0);
+    else if (m_toggleFFT->GetValue())
         s_fftpos.VReset(m_graph->GetSize().y);
     else
         s_drpos.VReset(m_graph->GetSize().y);
@@ -20,46 +20,34 @@
 #ifndef ANALYSISWIN_INCLUDED
 #define ANALYSISWIN_INCLUDED
 
+#include "garun.h"
 #include "LogViewFrame.h"
 
-struct GuideSession;
-
-class Spline
+// identifies the inputs of an analysis for the result cache
+struct AnalysisKey
 {
-    void *spline;
-    void *accel;
-public:
-    Spline() : spline(nullptr), accel(nullptr) { }
-    Spline(const double *x, const double *y, size_t n) : spline(nullptr), accel(nullptr) { Init(x, y, n); }
-    void Init(const double *x, const double *y, size_t n);
-    ~Spline();
-    double Eval(double x) const;
-};
+    const GuideSession *session;
+    size_t begin;
+    size_t end;
+    unsigned long long mask; // hash of the include flags of the frames in [begin, end)
+    bool raw_ra;             // RA corrections removed
+    SpectrumOptions opts;
 
-struct GARun
-{
-    wxDateTime starts;
-    double pixscale;
-    size_t len;
-    double *t;
-    double *rac;  // drift-corrected RA
-    double *decc; // drift-corrected Dec
-    size_t nfft;
-    double *fftx; // FFT period
-    double *ffty; // FFT amplitude
-    Spline ffts;  // FFT spline for graphing
-    double fftymax;
-    GARun() : len(0), t(nullptr), rac(nullptr), decc(nullptr), nfft(0), fftx(nullptr), ffty(nullptr) { }
-    ~GARun();
-    static bool CanAnalyze(const GuideSession& session, size_t begin, size_t end);
-    void Analyze(const GuideSession& session, size_t begin, size_t end, bool undo_ra_corrections);
+    AnalysisKey() : session(nullptr), begin(0), end(0), mask(0), raw_ra(false) { }
+    bool operator==(const AnalysisKey& rhs) const;
 };
 
+class AnalysisWorker;
+
 class AnalysisWin : public AnalyzeFrameBase
 {
 public:
     GARun m_garun;
     int m_cursor;
+    AnalysisWorker *m_worker;
+    AnalysisKey m_key; // inputs of m_garun
+    GARun *m_spare;    // buffers of the previous result, reused for the next request
+    PaintProfile m_profile;
 
 public:
     AnalysisWin(LogViewFrame *parent);
@@ -72,18 +60,37 @@ public:
     void AnalyzeAll(const GuideSession& session, bool undo_ra_corrections);
     void RefreshGraph();
 
+    // forget cached results, call when the log is reloaded
+    static void ClearCache();
+
+    // called on the UI thread by the worker
+    void OnAnalysisProgress(int percent);
+    void OnAnalysisDone();
+    // have the worker compute the spectrogram of the displayed result if
+    // it is shown and out of date with the Welch settings
+    void RequestSpectrogram();
+
 private:
+    bool HaveData() const { return m_garun.nfft != 0; }
+    void Analyze(const GuideSession& session, size_t begin, size_t end, bool undo_ra_corrections);
+    GARun *TakeSpare();
+    void Submit(GARun *run, const AnalysisKey& key);
+    void ShowResult(const AnalysisKey& key);
+
     void OnClose(wxCloseEvent& event) override;
     void OnSizeGraph(wxSizeEvent& event) override;
     void OnCheck(wxCommandEvent& event) override;
     void OnBtnLeftDown(wxMouseEvent& event) override;
     void OnClickDrift(wxCommandEvent& event) override;
     void OnClickFFT(wxCommandEvent& event) override;
+    void OnClickSpectrogram(wxCommandEvent& event) override;
+    void OnSpectrum(wxCommandEvent& event) override;
     void OnLeftDown(wxMouseEvent& event) override;
     void OnLeftUp(wxMouseEvent& event) override;
     void OnMouseWheel(wxMouseEvent& event) override;
     void OnMove(wxMouseEvent& event) override;
     void OnCaptureLost(wxMouseCaptureLostEvent& evt);
+    void OnKeyDown(wxKeyEvent& event);
     void OnPaintGraph(wxPaintEvent& event) override;
     void OnHMinus(wxCommandEvent& event) override;
     void OnHPlus(wxCommandEvent& event) override;
@@ -95,6 +102,10 @@ private:
     wxDECLARE_EVENT_TABLE();
 };
 
+// Draw the drift (or with fft the spectrum) plot of an analyzed run
+// without a window, filling size; for export.
+void PaintAnalysisPlot(wxDC& dc, const wxSize& size, const GARun& ga, bool fft, bool arcsecs);
+
 inline void AnalysisWin::RefreshGraph()
 {
     m_graph->Refresh();
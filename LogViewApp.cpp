@@ -22,6 +22,9 @@
 
 #include <gsl/gsl_errno.h>
 #include <wx/cmdline.h>
+#include <wx/image.h>
+
+#include <stdio.h>
 
 wxConfigBase *Config = 0;
 
@@ -34,7 +37,10 @@ static void gsl_error_handler(const char *reason, const char *file, int line, in
 
 LogViewApp::LogViewApp()
     :
-    m_frame(0)
+    m_frame(0),
+    m_exportSize(1600, 600),
+    m_exportSvg(false),
+    m_exportTiming(false)
 {
     SetVendorName("adgsoftware");
     SetAppName("phdlogview");
@@ -48,6 +54,15 @@ bool LogViewApp::OnInit()
 
     wxLog::SetActiveTarget(new wxLogStderr());
 
+    if (!m_exportDir.IsEmpty())
+    {
+        // batch export, no windows
+        wxImage::AddHandler(new wxPNGHandler());
+        LoadSettings();
+        gsl_set_error_handler(&gsl_error_handler);
+        return true;
+    }
+
     m_frame = new LogViewFrame();
     m_frame->Show();
 
@@ -59,6 +74,20 @@ bool LogViewApp::OnInit()
     return true;
 }
 
+int LogViewApp::OnRun()
+{
+    if (m_exportDir.IsEmpty())
+        return wxApp::OnRun();
+
+    int ret = 0;
+    for (size_t i = 0; i < m_exportFiles.size(); i++)
+    {
+        if (!ExportLog(m_exportFiles[i], m_exportDir, m_exportSize, m_exportSvg, m_exportTiming))
+            ret = 1;
+    }
+    return ret;
+}
+
 int LogViewApp::OnExit()
 {
     return wxApp::OnExit();
@@ -66,11 +95,35 @@ int LogViewApp::OnExit()
 
 void LogViewApp::OnInitCmdLine(wxCmdLineParser& parser)
 {
-    parser.AddParam("filename", wxCMD_LINE_VAL_STRING, wxCMD_LINE_PARAM_OPTIONAL);
+    parser.AddParam("filename", wxCMD_LINE_VAL_STRING, wxCMD_LINE_PARAM_OPTIONAL | wxCMD_LINE_PARAM_MULTIPLE);
+    parser.AddOption("e", "export", "write the graphs of the log files to directory dir and exit", wxCMD_LINE_VAL_STRING);
+    parser.AddOption("s", "size", "size of the exported graphs, WxH (default 1600x600)", wxCMD_LINE_VAL_STRING);
+    parser.AddSwitch("", "svg", "export SVG files instead of PNG");
+    parser.AddSwitch("", "timing", "also time drawing the guide graphs without a display, the scatter plot of a synthetic million-frame session and the FFT lengths, into <log>-timing.txt");
 }
 
 bool LogViewApp::OnCmdLineParsed(wxCmdLineParser& parser)
 {
+    if (parser.Found("export", &m_exportDir))
+    {
+        wxString size;
+        if (parser.Found("size", &size))
+        {
+            int w, h;
+            if (sscanf(size.c_str(), "%dx%d", &w, &h) != 2 || w < 100 || h < 100)
+            {
+                wxLogError("Invalid size '%s', expected WxH", size);
+                return false;
+            }
+            m_exportSize = wxSize(w, h);
+        }
+        m_exportSvg = parser.Found("svg");
+        m_exportTiming = parser.Found("timing");
+        for (size_t i = 0; i < parser.GetParamCount(); i++)
+            m_exportFiles.Add(parser.GetParam(i));
+        return !m_exportFiles.IsEmpty();
+    }
+
     if (parser.GetParamCount() > 1)
         return false;
     if (parser.GetParamCount() == 1)
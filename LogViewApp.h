@@ -22,6 +22,7 @@
 
 #include <wx/app.h>
 #include <wx/config.h>
+#include <wx/gdicmn.h>
 
 class LogViewFrame;
 
@@ -31,6 +32,11 @@ class LogViewApp : public wxApp
 {
     LogViewFrame *m_frame;
     wxString m_openFile;
+    wxString m_exportDir;       // export the graphs of m_exportFiles and exit
+    wxArrayString m_exportFiles;
+    wxSize m_exportSize;
+    bool m_exportSvg;
+    bool m_exportTiming;        // also time the rendering of the guide graphs
 
 public:
     LogViewApp();
@@ -38,6 +44,7 @@ public:
 
 private:
     bool OnInit();
+    int OnRun();
     int OnExit();
     void OnInitCmdLine(wxCmdLineParser& parser);
     bool OnCmdLineParsed(wxCmdLineParser& parser);
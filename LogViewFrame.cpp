@@ -20,13 +20,17 @@
 #include "LogViewFrame.h"
 #include "LogViewApp.h"
 #include "AnalysisWin.h"
+#include "drawlist.h"
 #include "logparser.h"
+#include "minmax.h"
+#include "parallel.h"
 
 #include <wx/aboutdlg.h>
 #include <wx/busyinfo.h>
 #include <wx/clipbrd.h>
 #include <wx/colordlg.h>
 #include <wx/dcbuffer.h>
+#include <wx/dcsvg.h>
 #include <wx/dnd.h>
 #include <wx/filedlg.h>
 #include <wx/graphics.h>
@@ -40,17 +44,28 @@
 #include <wx/wupdlock.h>
 
 #include <algorithm>
+#include <condition_variable>
+#include <deque>
 #include <fstream>
+#include <functional>
 #include <iomanip>
+#include <map>
 #include <math.h>
+#include <memory>
+#include <mutex>
 #include <sstream>
+#include <string.h>
+#include <thread>
 
 #define MAX_HSCALE_GUIDE 100.0
 #define MIN_HSCALE_GUIDE 0.1
 #define MAX_HSCALE_CAL 400.0
 #define MIN_HSCALE_CAL 5.0
-#define DECEL 0.03
+#define DECEL 0.03 // growth of the kinetic pan deceleration per KINETIC_TICK
+#define KINETIC_TICK 20.0 // ms
+#define FRAME_MS 16 // shortest interval between graph repaints
 #define MIN_SHOW 25
+#define LOD_HSCALE 0.5 // draw from the min/max pyramid below this many pixels per entry
 
 #define APP_NAME "PHD2 Log Viewer"
 #define APP_VERSION_STR "0.6.4"
@@ -83,10 +98,23 @@ struct DragInfo
     wxLongLong_t m_mouseTime[2];
     double decel;
     wxRealPoint m_rate; // pixels per millisecond
+    wxRealPoint m_residual; // kinetic pan movement not yet applied, pixels
 };
 static DragInfo s_drag;
 
+// frames last selected with an include drag, for the range stats
+struct SelRange
+{
+    const GuideSession *session;
+    size_t begin;
+    size_t end;
+
+    SelRange() : session(nullptr), begin(0), end(0) { }
+};
+static SelRange s_selRange;
+
 static int s_analyze_pos;
+static int s_rowInfoIdx = -1; // entry shown in m_rowInfo
 
 struct ScatterPlot
 {
@@ -98,6 +126,296 @@ struct ScatterPlot
 };
 static ScatterPlot s_scatter;
 
+// values shared by the layers of one paint of the guide graph
+struct GraphPaint
+{
+    const GuideSession *session;
+    const GraphInfo *ginfo;     // scale and offset, the session's own or an export's
+    unsigned int opts;          // GOPT_ flags
+    PaintProfile *profile;
+    int left, right;            // screen columns being drawn
+    unsigned int i0, i1;        // entries that can reach those columns
+    int width, height;
+    int y00;                    // vertical center
+    int y0;                     // zero line
+    double vscale;
+    bool radec;
+    const MinMaxPyramid *lod;   // null to draw every entry
+};
+
+enum GraphLayer
+{
+    LAYER_BACKGROUND,   // grid, time ticks, limits
+    LAYER_DATA,         // corrections, mass, snr, ra, dec
+    LAYER_ANNOTATIONS,  // excluded sections, events
+    NUM_LAYERS,
+};
+
+enum GraphOption
+{
+    GOPT_GRID = 1 << 0,
+    GOPT_LIMITS = 1 << 1,
+    GOPT_RA = 1 << 2,
+    GOPT_DEC = 1 << 3,
+    GOPT_ARCSECS = 1 << 4,
+    GOPT_CORRECTIONS = 1 << 5,
+    GOPT_MASS = 1 << 6,
+    GOPT_SNR = 1 << 7,
+    GOPT_RADEC = 1 << 8,
+    GOPT_MOUNT = 1 << 9,
+    GOPT_EVENTS = 1 << 10,
+
+    GOPT_BACKGROUND = GOPT_GRID | GOPT_LIMITS | GOPT_RA | GOPT_DEC | GOPT_ARCSECS,
+    GOPT_DATA = GOPT_BACKGROUND | GOPT_CORRECTIONS | GOPT_MASS | GOPT_SNR | GOPT_RADEC | GOPT_MOUNT,
+};
+
+// bumped whenever the include flags of the displayed session change
+static unsigned int s_includeGen;
+
+// Everything a layer of the guide graph depends on. The layers are
+// cumulative, so each one also depends on the inputs of the layers below.
+struct GraphLayerKey
+{
+    const GuideSession *session;
+    int width, height;
+    double hscale, vscale;
+    int xofs, yofs;
+    unsigned int opts;          // GraphOption flags
+    wxUint32 raColor, decColor;
+    const MinMaxPyramid *lod;
+    unsigned int includeGen;
+
+    GraphLayerKey ForLayer(int layer) const
+    {
+        GraphLayerKey k(*this);
+        if (layer < LAYER_ANNOTATIONS)
+        {
+            k.opts &= GOPT_DATA;
+            k.includeGen = 0;
+        }
+        if (layer < LAYER_DATA)
+        {
+            k.opts &= GOPT_BACKGROUND;
+            k.lod = nullptr;
+        }
+        return k;
+    }
+
+    // the rendering can be scrolled into the other's
+    bool SameExceptOffset(const GraphLayerKey& rhs) const
+    {
+        return session == rhs.session && width == rhs.width && height == rhs.height &&
+            hscale == rhs.hscale && vscale == rhs.vscale && yofs == rhs.yofs &&
+            opts == rhs.opts && raColor == rhs.raColor && decColor == rhs.decColor &&
+            lod == rhs.lod && includeGen == rhs.includeGen;
+    }
+
+    bool operator==(const GraphLayerKey& rhs) const
+    {
+        return xofs == rhs.xofs && SameExceptOffset(rhs);
+    }
+};
+
+// Cached renderings of the guide graph, so that a repaint that only
+// changes the overlay (like dragging out a selection) is a single blit.
+struct GraphLayers
+{
+    wxBitmap bmp[NUM_LAYERS];
+    DrawList list[NUM_LAYERS];  // the last strip drawn on each, kept for its storage
+    wxBitmap scratch;           // for scrolling
+    GraphLayerKey key[NUM_LAYERS];
+    bool valid[NUM_LAYERS];
+    GraphLayers() { Invalidate(); }
+    void Invalidate() { for (int i = 0; i < NUM_LAYERS; i++) valid[i] = false; }
+};
+static GraphLayers s_layers;
+
+// Event labels of one session with their widths in the graph font, and
+// their stacking into rows at one zoom level
+struct EventLabels
+{
+    const GuideSession *session;
+    wxFont font;
+    std::vector<wxString> text;
+    std::vector<int> width;
+
+    double hscale;              // zoom level of the layout, 0 if none
+    std::vector<int> xpos;      // position within the session, pixels
+    std::vector<int> row;       // 1 = bottom row
+    std::vector<int> reach;     // right end of the widest label up to this one
+
+    EventLabels() : session(nullptr), hscale(0.) { }
+    void Invalidate() { session = nullptr; hscale = 0.; }
+    void Update(wxDC& dc, const GuideSession *s, double hscale);
+    // index of the first label that extends past session position x
+    size_t FirstReaching(int x) const
+    {
+        return std::upper_bound(reach.begin(), reach.end(), x) - reach.begin();
+    }
+};
+static EventLabels s_eventLabels;
+
+void EventLabels::Update(wxDC& dc, const GuideSession *s, double hs)
+{
+    if (s != session || dc.GetFont() != font)
+    {
+        session = s;
+        font = dc.GetFont();
+        hscale = 0.;
+        const GuideSession::InfoVec& infos = s->infos;
+        text.resize(infos.size());
+        width.resize(infos.size());
+        for (size_t i = 0; i < infos.size(); i++)
+        {
+            const auto& info = infos[i];
+            text[i] = info.repeats > 1 ? wxString::Format("%d x %s", info.repeats, info.info) : wxString(info.info);
+            width[i] = dc.GetTextExtent(text[i]).x;
+        }
+    }
+
+    if (hs == hscale)
+        return;
+
+    // the rows are laid out from the start of the session, not the left
+    // edge of the window, so a label keeps its row when scrolled
+    hscale = hs;
+    size_t n = text.size();
+    xpos.resize(n);
+    row.resize(n);
+    reach.resize(n);
+    int prev_end = -999999;
+    int r = 1;
+    for (size_t i = 0; i < n; i++)
+    {
+        int x = (int) floor(session->infos[i].idx * hscale);
+        if (x < prev_end + 10)
+            ++r;
+        else
+            r = 1;
+        if (x + width[i] > prev_end)
+            prev_end = x + width[i];
+        xpos[i] = x;
+        row[i] = r;
+        reach[i] = prev_end;
+    }
+}
+
+// call after changing the include flags of the displayed session
+static void IncludesChanged()
+{
+    ++s_includeGen;
+    s_scatter.Invalidate();
+}
+
+// Builds the min/max pyramids of the guiding sessions on a background
+// thread, in the order they are first asked for. A finished pyramid is
+// immutable and stays valid until Clear().
+class LodBuilder
+{
+    typedef std::map<const GuideSession *, std::unique_ptr<MinMaxPyramid> > PyramidMap;
+
+    LogViewFrame *m_frame;
+    std::mutex m_lock;
+    std::condition_variable m_cond;
+    std::deque<const GuideSession *> m_queue;
+    PyramidMap m_done;
+    bool m_busy;
+    bool m_quit;
+    std::atomic<bool> m_cancel;
+    std::thread m_thread;
+
+    void Run();
+
+public:
+    LodBuilder() : m_frame(nullptr), m_busy(false), m_quit(false), m_cancel(false) { }
+    ~LodBuilder() { Stop(); }
+
+    // the session's pyramid, or null if it is not ready yet, in which case
+    // the build is started and frame->OnLodReady() is called when it is done
+    const MinMaxPyramid *Get(LogViewFrame *frame, const GuideSession *session);
+    // drop all pyramids, call before the sessions are destroyed
+    void Clear();
+    void Stop();
+};
+static LodBuilder s_lod;
+
+const MinMaxPyramid *LodBuilder::Get(LogViewFrame *frame, const GuideSession *session)
+{
+    std::lock_guard<std::mutex> lck(m_lock);
+
+    auto it = m_done.find(session);
+    if (it != m_done.end())
+        return it->second.get();
+
+    if (std::find(m_queue.begin(), m_queue.end(), session) == m_queue.end())
+    {
+        m_frame = frame;
+        m_queue.push_back(session);
+        if (!m_thread.joinable())
+            m_thread = std::thread(&LodBuilder::Run, this);
+        m_cond.notify_one();
+    }
+
+    return nullptr;
+}
+
+void LodBuilder::Clear()
+{
+    std::unique_lock<std::mutex> lck(m_lock);
+    m_queue.clear();
+    m_cancel = true;
+    // the build in progress is reading the session's entries
+    while (m_busy)
+        m_cond.wait(lck);
+    m_cancel = false;
+    m_done.clear();
+}
+
+void LodBuilder::Stop()
+{
+    if (!m_thread.joinable())
+        return;
+    {
+        std::lock_guard<std::mutex> lck(m_lock);
+        m_quit = true;
+        m_cancel = true;
+    }
+    m_cond.notify_all();
+    m_thread.join();
+}
+
+void LodBuilder::Run()
+{
+    std::unique_lock<std::mutex> lck(m_lock);
+
+    while (true)
+    {
+        while (!m_quit && m_queue.empty())
+            m_cond.wait(lck);
+        if (m_quit)
+            break;
+
+        const GuideSession *session = m_queue.front();
+        m_queue.pop_front();
+        m_busy = true;
+        lck.unlock();
+
+        std::unique_ptr<MinMaxPyramid> pyr(new MinMaxPyramid());
+        bool ok = pyr->Build(session->entries, m_cancel);
+
+        lck.lock();
+        m_busy = false;
+        if (ok && !m_cancel)
+            m_done[session] = std::move(pyr);
+        else
+            ok = false;
+        m_cond.notify_all();
+
+        if (ok)
+            m_frame->CallAfter(&LogViewFrame::OnLodReady);
+    }
+}
+
 struct FileDropTarget : public wxFileDropTarget
 {
     LogViewFrame *m_lvf;
@@ -115,12 +433,15 @@ struct FileDropTarget : public wxFileDropTarget
 enum
 {
     ID_TIMER = 10001,
+    ID_FRAME_TIMER,
     ID_INCLUDE_ALL,
     ID_INCLUDE_NONE,
     ID_EXCLUDE_SETTLE,
+    ID_EXCLUDE_OUTLIERS,
     ID_ANALYZE_GA,
     ID_ANALYZE_ALL,
     ID_ANALYZE_ALL_NORA,
+    ID_SCATTER_DENSITY,
 };
 
 wxBEGIN_EVENT_TABLE(LogViewFrame, LogViewFrameBase)
@@ -129,11 +450,13 @@ wxBEGIN_EVENT_TABLE(LogViewFrame, LogViewFrameBase)
   EVT_MENU(wxID_EXIT, LogViewFrame::OnFileExit)
   EVT_MENU(wxID_HELP, LogViewFrame::OnHelp)
   EVT_MENU(wxID_ABOUT, LogViewFrame::OnHelpAbout)
-  EVT_MENU_RANGE(ID_INCLUDE_ALL, ID_EXCLUDE_SETTLE, LogViewFrame::OnMenuInclude)
+  EVT_MENU_RANGE(ID_INCLUDE_ALL, ID_EXCLUDE_OUTLIERS, LogViewFrame::OnMenuInclude)
   EVT_MENU(ID_ANALYZE_GA, LogViewFrame::OnMenuAnalyzeGA)
   EVT_MENU_RANGE(ID_ANALYZE_ALL, ID_ANALYZE_ALL_NORA, LogViewFrame::OnMenuAnalyzeAll)
+  EVT_MENU(ID_SCATTER_DENSITY, LogViewFrame::OnMenuScatterDensity)
   EVT_MOUSEWHEEL(LogViewFrame::OnMouseWheel)
   EVT_TIMER(ID_TIMER, LogViewFrame::OnTimer)
+  EVT_TIMER(ID_FRAME_TIMER, LogViewFrame::OnFrameTimer)
 wxEND_EVENT_TABLE()
 
 inline static bool vscale_locked()
@@ -197,6 +520,23 @@ void LoadGeometry(wxFrame *win, const wxString& key)
     }
 }
 
+void LoadSettings()
+{
+    s_settings.excludeByServer = Config->ReadBool("/settle/excludeByServer", true);
+    s_settings.excludeParametric = Config->ReadBool("/settle/excludeParametric", false);
+    s_settings.settle.pixels = Config->ReadDouble("/settle/pixels", 1.0);
+    s_settings.settle.seconds = Config->ReadDouble("/settle/seconds", 10.0);
+    s_settings.excludeOutliers = Config->ReadBool("/outliers/exclude", false);
+    s_settings.outliers.sigma = Config->ReadDouble("/outliers/sigma", 3.0);
+    s_settings.outliers.iterations = Config->ReadLong("/outliers/iterations", 5);
+    s_settings.welch.segment = Config->ReadDouble("/welch/segment", 600.0);
+    s_settings.welch.overlap = Config->ReadDouble("/welch/overlap", 0.5);
+    s_settings.raColor = wxColor(Config->Read("/color/ra", wxColor(100, 100, 255).GetAsString(wxC2S_HTML_SYNTAX)));
+    s_settings.decColor = wxColor(Config->Read("/color/dec", wxRED->GetAsString(wxC2S_HTML_SYNTAX)));
+    s_settings.vscale = Config->ReadDouble("/vscale", 0.0);
+    s_settings.scatterDensity = Config->ReadBool("/scatter/density", false);
+}
+
 LogViewFrame::LogViewFrame()
     :
     LogViewFrameBase(0),
@@ -204,6 +544,8 @@ LogViewFrame::LogViewFrame()
     m_session(nullptr),
     m_calibration(nullptr),
     m_timer(this, ID_TIMER),
+    m_frameTimer(this, ID_FRAME_TIMER),
+    m_lastPaint(0),
     m_analysisWin(nullptr)
 {
     SetTitle(APP_NAME);
@@ -232,13 +574,7 @@ LogViewFrame::LogViewFrame()
         m_splitter2->SetSashPosition(val);
     }
 
-    s_settings.excludeByServer = Config->ReadBool("/settle/excludeByServer", true);
-    s_settings.excludeParametric = Config->ReadBool("/settle/excludeParametric", false);
-    s_settings.settle.pixels = Config->ReadDouble("/settle/pixels", 1.0);
-    s_settings.settle.seconds = Config->ReadDouble("/settle/seconds", 10.0);
-    s_settings.raColor = wxColor(Config->Read("/color/ra", wxColor(100, 100, 255).GetAsString(wxC2S_HTML_SYNTAX)));
-    s_settings.decColor = wxColor(Config->Read("/color/dec", wxRED->GetAsString(wxC2S_HTML_SYNTAX)));
-    s_settings.vscale = Config->ReadDouble("/vscale", 0.0);
+    LoadSettings();
 
     m_raLegend->SetForegroundColour(s_settings.raColor);
     m_decLegend->SetForegroundColour(s_settings.decColor);
@@ -250,6 +586,7 @@ LogViewFrame::LogViewFrame()
 
 LogViewFrame::~LogViewFrame()
 {
+    s_lod.Stop();
     if (m_analysisWin)
         m_analysisWin->Destroy();
 }
@@ -300,7 +637,7 @@ static void ExcludeSettlingByAPI(GuideSession *session)
     {
         if (settling)
         {
-            if (it->info.find("Settling complete") != wxString::npos || it->info.find("Settling fail") != wxString::npos)
+            if (it->type == INFO_SETTLE_DONE || it->type == INFO_SETTLE_FAIL)
             {
                 settling = false;
                 IncludeRange(entries, false, start_idx, it->idx);
@@ -308,7 +645,7 @@ static void ExcludeSettlingByAPI(GuideSession *session)
         }
         else
         {
-            if (it->info.find("Settling start") != wxString::npos)
+            if (it->type == INFO_SETTLE_START)
             {
                 settling = true;
                 start_idx = it->idx;
@@ -319,66 +656,213 @@ static void ExcludeSettlingByAPI(GuideSession *session)
         IncludeRange(entries, false, start_idx);
 }
 
-static void ExcludeSettlingByDistance(GuideSession *session, const SettleParams& params)
+// Find where each dither settled in a single pass over the frames.
+//
+// A dither is settled at the first frame where the star has stayed within
+// params.pixels of the lock position for more than params.seconds, counting
+// from the dither or from the start of the current run of close frames,
+// whichever is later. Pending dithers are kept in order; the oldest one has
+// the earliest start time so it is always the first to settle.
+static void FindSettling(GuideSession *session, const SettleParams& params)
 {
-    auto& infos = session->infos;
-    auto& entries = session->entries;
-    double lim2 = params.pixels * params.pixels;
+    const auto& infos = session->infos;
+    const auto& entries = session->entries;
+    const auto& dist2 = session->dist2;
+    auto& settles = session->settles;
+    float lim2 = (float)(params.pixels * params.pixels);
 
-    for (auto it = infos.begin(); it != infos.end(); ++it)
+    settles.clear();
+
+    std::deque<size_t> pending; // indexes into settles
+    int run_start = -1;         // first frame of the current run of close frames
+    int n = std::min(entries.size(), dist2.size());
+    auto info = infos.begin();
+
+    for (int i = 0; i < n; i++)
     {
-        if (it->info.find("DITHER") != wxString::npos)
+        for (; info != infos.end() && info->idx <= i; ++info)
         {
-            if (it->idx >= (int)entries.size())
-                break;
-            int start_idx = it->idx;
-            auto eit = entries.begin() + it->idx;
-            double start_time = eit->dt;
-            bool close = false;
-            bool settled = false;
-            int end_idx = start_idx;
-
-            for (; eit != entries.end(); ++eit, ++end_idx)
+            if (info->type == INFO_DITHER)
             {
-                double dx = eit->dx;
-                double dy = eit->dy;
-                double d2 = dx * dx + dy * dy;
-                double t = eit->dt;
-                if (d2 < lim2)
-                {
-                    if (!close)
-                    {
-                        close = true;
-                        start_time = t;
-                    }
-                    else
-                    {
-                        double elapsed = t - start_time;
-                        if (elapsed > params.seconds)
-                        {
-                            settled = true;
-                            break;
-                        }
-                    }
-                }
-                else
-                {
-                    close = false;
-                }
+                DitherSettle ds;
+                ds.idx = info->idx;
+                ds.settle_idx = -1;
+                ds.settle_time = 0.f;
+                pending.push_back(settles.size());
+                settles.push_back(ds);
             }
-            if (settled)
-                IncludeRange(entries, false, start_idx, end_idx);
         }
+
+        if (dist2[i] >= lim2)
+        {
+            run_start = -1;
+            continue;
+        }
+
+        if (run_start < 0)
+            run_start = i;
+
+        double t = entries[i].dt;
+        while (!pending.empty())
+        {
+            DitherSettle& ds = settles[pending.front()];
+            int start = std::max(ds.idx, run_start);
+            if (t - entries[start].dt <= params.seconds)
+                break;
+            ds.settle_idx = i;
+            ds.settle_time = (float)(t - entries[ds.idx].dt);
+            pending.pop_front();
+        }
+    }
+}
+
+static void ExcludeSettlingByDistance(GuideSession *session)
+{
+    auto& entries = session->entries;
+    const auto& settles = session->settles;
+
+    // settles are ordered by dither and by settle frame, so overlapping
+    // ranges can be merged as we go
+    int start = -1, end = -1;
+    for (auto it = settles.begin(); it != settles.end(); ++it)
+    {
+        if (it->settle_idx < 0)
+            continue;
+        if (it->idx > end)
+        {
+            if (start >= 0)
+                IncludeRange(entries, false, start, end);
+            start = it->idx;
+        }
+        end = std::max(end, it->settle_idx);
     }
+    if (start >= 0)
+        IncludeRange(entries, false, start, end);
 }
 
 static void ExcludeSettling(GuideSession *session)
 {
+    // always run the settle detector for the per-dither settle stats
+    FindSettling(session, s_settings.settle);
+
     if (s_settings.excludeByServer)
         ExcludeSettlingByAPI(session);
 
     if (s_settings.excludeParametric)
-        ExcludeSettlingByDistance(session, s_settings.settle);
+        ExcludeSettlingByDistance(session);
+}
+
+// median of v[0..n), reorders v
+static float Median(float *v, size_t n)
+{
+    std::nth_element(v, v + n / 2, v + n);
+    return v[n / 2];
+}
+
+// median absolute deviation of v[0..n) from med, using tmp for scratch
+static float MedianAbsDev(const float *v, size_t n, float med, float *tmp)
+{
+    for (size_t i = 0; i < n; i++)
+        tmp[i] = fabsf(v[i] - med);
+    return Median(tmp, n);
+}
+
+// Iterative sigma clipping on the total guide error.
+//
+// The errors are centred on the median RA and Dec of the frames rather
+// than on the lock position, so a session with steady drift or an offset
+// lock position is not clipped on its offset. Each axis is scaled by its
+// MAD, which for normal errors is 0.6745 standard deviations, so the
+// spikes being removed do not inflate the threshold; a frame is clipped
+// when its scaled distance from the centre exceeds sigma. Each pass is
+// medians and a compare over flat columns of the RA and Dec of the frames
+// still included; clipped frames are then excluded in the session.
+static void ExcludeOutliers(GuideSession *session, const OutlierParams& params)
+{
+    auto& entries = session->entries;
+
+    std::vector<unsigned int> idx;  // candidate frames
+    idx.reserve(entries.size());
+    for (size_t i = 0; i < entries.size(); i++)
+        if (entries[i].included && StarWasFound(entries[i].err))
+            idx.push_back(i);
+
+    size_t n = idx.size();
+    if (n < 3)
+        return;
+
+    std::vector<float> ra(n), dec(n), tmp(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        ra[i] = entries[idx[i]].raraw;
+        dec[i] = entries[idx[i]].decraw;
+    }
+
+    // MAD of a normal distribution in standard deviations
+    static const double MAD_SIGMA = 0.6745;
+
+    for (int iter = 0; iter < params.iterations && n >= 3; iter++)
+    {
+        std::copy(ra.begin(), ra.begin() + n, tmp.begin());
+        float const cra = Median(&tmp[0], n);
+        std::copy(dec.begin(), dec.begin() + n, tmp.begin());
+        float const cdec = Median(&tmp[0], n);
+        float const madra = MedianAbsDev(&ra[0], n, cra, &tmp[0]);
+        float const maddec = MedianAbsDev(&dec[0], n, cdec, &tmp[0]);
+
+        // most frames are at the same position, nothing sensible to clip
+        if (madra <= 0.f || maddec <= 0.f)
+            break;
+
+        float const sra = (float)(MAD_SIGMA / (params.sigma * madra));
+        float const sdec = (float)(MAD_SIGMA / (params.sigma * maddec));
+
+        // a branch-free count first, which the compiler can vectorize; the
+        // last pass usually clips nothing and ends here
+        size_t nclip = 0;
+        for (size_t i = 0; i < n; i++)
+        {
+            float const x = (ra[i] - cra) * sra;
+            float const y = (dec[i] - cdec) * sdec;
+            nclip += x * x + y * y > 1.f ? 1 : 0;
+        }
+        if (nclip == 0)
+            break;
+
+        // compact the columns, dropping the clipped frames
+        size_t m = 0;
+        for (size_t i = 0; i < n; i++)
+        {
+            float const x = (ra[i] - cra) * sra;
+            float const y = (dec[i] - cdec) * sdec;
+            if (x * x + y * y > 1.f)
+            {
+                entries[idx[i]].included = false;
+                continue;
+            }
+            idx[m] = idx[i];
+            ra[m] = ra[i];
+            dec[m] = dec[i];
+            ++m;
+        }
+        n = m;
+    }
+}
+
+// apply the exclusion settings to the sessions of a newly parsed log and
+// get their stats
+static void PrepareSessions()
+{
+    // the sessions are independent, so get their stats in parallel
+    ParallelFor(s_log.sessions.size(), [](size_t i) {
+        GuideSession *session = &s_log.sessions[i];
+        IncludeAll(session->entries);
+        ExcludeSettling(session);
+        if (s_settings.excludeOutliers)
+            ExcludeOutliers(session, s_settings.outliers);
+        session->CalcStats();
+    });
+    s_log.CalcSummary();
 }
 
 void LogViewFrame::OpenLog(const wxString& filename)
@@ -411,6 +895,13 @@ void LogViewFrame::OpenLog(const wxString& filename)
     m_sessions->ClearGrid();
     m_sessions->EndBatch();
     m_rowInfo->Clear();
+    s_rowInfoIdx = -1;
+    // cached analyses are keyed by session address, which the new log may reuse
+    AnalysisWin::ClearCache();
+    s_lod.Clear();
+    s_selRange = SelRange();
+    s_layers.Invalidate();
+    s_eventLabels.Invalidate();
     wxGetApp().Yield();
 
     {
@@ -422,6 +913,8 @@ void LogViewFrame::OpenLog(const wxString& filename)
     if (!s_log.phd_version.empty())
         SetTitle(wxString::Format(APP_NAME " - %s - PHD2 %s", fn.GetFullName(), s_log.phd_version.c_str()));
 
+    PrepareSessions();
+
     // load the grid
     m_sessions->BeginBatch();
     int row = 0;
@@ -441,14 +934,21 @@ void LogViewFrame::OpenLog(const wxString& filename)
         {
             s = &s_log.sessions[it->idx];
             GuideSession *session = static_cast<GuideSession*>(s);
-            IncludeAll(session->entries);
-            ExcludeSettling(session);
-            session->CalcStats();
             m_sessions->SetCellValue(row, 2, "Guiding");
             m_sessions->SetCellValue(row, 3, durStr(session->duration));
         }
         m_sessions->SetCellValue(row, 1, s->date);
     }
+    if (!s_log.sessions.empty())
+    {
+        // whole log summary row
+        if (row >= m_sessions->GetNumberRows())
+            m_sessions->AppendRows(1, false);
+        m_sessions->SetCellValue(row, 0, wxEmptyString);
+        m_sessions->SetCellValue(row, 1, "Whole log");
+        m_sessions->SetCellValue(row, 2, wxString::Format("%u sessions", (unsigned int) s_log.sessions.size()));
+        m_sessions->SetCellValue(row, 3, durStr(s_log.summary.duration));
+    }
     m_sessions->GoToCell(0, 0);
     m_sessions->AutoSize();
     m_sessions->EndBatch();
@@ -528,6 +1028,23 @@ void LogViewFrame::OnFileSettings(wxCommandEvent& event)
     dlg.m_settlePixels->SetValidator(wxFloatingPointValidator<double>(2, &pixels, 0));
     double seconds = s_settings.settle.seconds;
     dlg.m_settleSeconds->SetValidator(wxFloatingPointValidator<double>(1, &seconds, 0));
+    dlg.m_excludeOutliers->SetValue(s_settings.excludeOutliers);
+    double sigma = s_settings.outliers.sigma;
+    wxFloatingPointValidator<double> sigmaVal(1, &sigma, 0);
+    sigmaVal.SetMin(0.5);
+    dlg.m_outlierSigma->SetValidator(sigmaVal);
+    int iterations = s_settings.outliers.iterations;
+    wxIntegerValidator<int> itersVal(&iterations);
+    itersVal.SetRange(1, 100);
+    dlg.m_outlierIters->SetValidator(itersVal);
+    double segment = s_settings.welch.segment;
+    wxFloatingPointValidator<double> segVal(0, &segment, 0);
+    segVal.SetMin(10.0);
+    dlg.m_welchSegment->SetValidator(segVal);
+    double overlap = s_settings.welch.overlap * 100.;
+    wxFloatingPointValidator<double> ovlVal(0, &overlap, 0);
+    ovlVal.SetRange(0., 90.);
+    dlg.m_welchOverlap->SetValidator(ovlVal);
     dlg.m_raColor = s_settings.raColor;
     dlg.m_decColor = s_settings.decColor;
     dlg.m_raColorBtn->SetForegroundColour(dlg.m_raColor);
@@ -540,6 +1057,11 @@ void LogViewFrame::OnFileSettings(wxCommandEvent& event)
     s_settings.excludeParametric = dlg.m_excludeByParam->GetValue();
     s_settings.settle.pixels = pixels;
     s_settings.settle.seconds = seconds;
+    s_settings.excludeOutliers = dlg.m_excludeOutliers->GetValue();
+    s_settings.outliers.sigma = sigma;
+    s_settings.outliers.iterations = iterations;
+    s_settings.welch.segment = segment;
+    s_settings.welch.overlap = overlap / 100.;
     s_settings.raColor = dlg.m_raColor;
     s_settings.decColor = dlg.m_decColor;
 
@@ -548,10 +1070,18 @@ void LogViewFrame::OnFileSettings(wxCommandEvent& event)
     m_raLegend->SetForegroundColour(s_settings.raColor);
     m_decLegend->SetForegroundColour(s_settings.decColor);
 
+    if (m_analysisWin)
+        m_analysisWin->RequestSpectrogram();
+
     Config->Write("/settle/excludeByServer", s_settings.excludeByServer);
     Config->Write("/settle/excludeParametric", s_settings.excludeParametric);
     Config->Write("/settle/pixels", s_settings.settle.pixels);
     Config->Write("/settle/seconds", s_settings.settle.seconds);
+    Config->Write("/outliers/exclude", s_settings.excludeOutliers);
+    Config->Write("/outliers/sigma", s_settings.outliers.sigma);
+    Config->Write("/outliers/iterations", s_settings.outliers.iterations);
+    Config->Write("/welch/segment", s_settings.welch.segment);
+    Config->Write("/welch/overlap", s_settings.welch.overlap);
     Config->Write("/color/ra", s_settings.raColor.GetAsString(wxC2S_HTML_SYNTAX));
     Config->Write("/color/dec", s_settings.decColor.GetAsString(wxC2S_HTML_SYNTAX));
 }
@@ -574,6 +1104,7 @@ void LogViewFrame::OnRightUp(wxMouseEvent& event)
     menu->Append(ID_INCLUDE_ALL, _("Include all frames"));
     menu->Append(ID_INCLUDE_NONE, _("Exclude all frames"));
     menu->Append(ID_EXCLUDE_SETTLE, _("Exclude frames settling"));
+    menu->Append(ID_EXCLUDE_OUTLIERS, _("Exclude outliers"));
     menu->AppendSeparator();
 
     wxMenuItem *mi1 = menu->Append(ID_ANALYZE_ALL, _("Analyze selected frames"));
@@ -599,6 +1130,12 @@ void LogViewFrame::OnRightUp(wxMouseEvent& event)
         }
     }
 
+    if (m_scatter->IsChecked())
+    {
+        menu->AppendSeparator();
+        menu->AppendCheckItem(ID_SCATTER_DENSITY, _("Scatter plot density"))->Check(s_settings.scatterDensity);
+    }
+
     wxWindow *w = wxDynamicCast(event.GetEventObject(), wxWindow);
     if (w)
         PopupMenu(menu, ScreenToClient(w->ClientToScreen(event.GetPosition())));
@@ -634,13 +1171,53 @@ static void InitStats(wxGrid *stats, wxHtmlWindow *stats2, const GuideSession *s
             "<tr><td>RA Drift</td><td>" << FormatNum(session->drift_ra * session->pixelScale) << "\"/min, " << FormatNum(session->drift_ra) << " px/min</td></tr>"
        <<  "<tr><td>Dec Drift</td><td>" << FormatNum(session->drift_dec * session->pixelScale) << "\"/min, " << FormatNum(session->drift_dec) << " px/min</td></tr>"
        <<  "<tr><td>Polar Alignment Error  </td><td>" << std::fixed << std::setprecision(1) << session->paerr << "'</td></tr>"
-       << "</table></span>";
+       << std::setprecision(2)
+       <<  "<tr><td>Median Error</td><td>" << session->median_err * session->pixelScale << "\", " << session->median_err << " px"
+       <<      " (MAD " << session->mad_err * session->pixelScale << "\", " << session->mad_err << " px)</td></tr>"
+       <<  "<tr><td>Exposure-weighted RMS</td><td>" << session->exp_rms * session->pixelScale << "\", " << session->exp_rms << " px</td></tr>"
+       <<  "<tr><td>P90/P95/P99</td><td>" << session->p90_err * session->pixelScale << "\" / " << session->p95_err * session->pixelScale
+       <<      "\" / " << session->p99_err * session->pixelScale << "\"</td></tr>";
+
+    if (s_selRange.session == session)
+    {
+        RangeStats st;
+        session->CalcRangeStats(s_selRange.begin, s_selRange.end, st);
+        os << "<tr><td>Selected Frames</td><td>" << s_selRange.begin << "-" << s_selRange.end - 1
+           <<      ", " << st.count << " included</td></tr>"
+           <<  "<tr><td>&nbsp;&nbsp;Median Error</td><td>" << st.median * session->pixelScale << "\", " << st.median << " px"
+           <<      " (MAD " << st.mad * session->pixelScale << "\", " << st.mad << " px)</td></tr>"
+           <<  "<tr><td>&nbsp;&nbsp;P90/P95/P99</td><td>" << st.p90 * session->pixelScale << "\" / " << st.p95 * session->pixelScale
+           <<      "\" / " << st.p99 * session->pixelScale << "\"</td></tr>";
+    }
+
+    if (!session->settles.empty())
+    {
+        std::vector<float> times;
+        for (auto it = session->settles.begin(); it != session->settles.end(); ++it)
+            if (it->settle_idx >= 0)
+                times.push_back(it->settle_time);
+        os << "<tr><td>Dither Settling</td><td>" << session->settles.size() << " dithers";
+        if (!times.empty())
+        {
+            std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+            float med = times[times.size() / 2];
+            float mx = *std::max_element(times.begin(), times.end());
+            os << ", median " << std::setprecision(1) << med << "s, max " << mx << "s";
+        }
+        size_t failed = session->settles.size() - times.size();
+        if (failed)
+            os << ", " << failed << " not settled";
+        os << "</td></tr>";
+    }
+
+    os << "</table></span>";
     stats2->SetPage(os.str());
 }
 
 static void UpdateStats(wxGrid *stats, wxHtmlWindow *stats2, GuideSession *session)
 {
     session->CalcStats();
+    s_log.CalcSummary();
     InitStats(stats, stats2, session);
 }
 
@@ -653,25 +1230,40 @@ void LogViewFrame::OnMenuInclude(wxCommandEvent& event)
     {
         IncludeAll(m_session->entries);
         UpdateStats(m_stats, m_stats2, m_session);
-        s_scatter.Invalidate();
+        IncludesChanged();
         m_graph->Refresh();
     }
     else if (event.GetId() == ID_INCLUDE_NONE)
     {
         IncludeNone(m_session->entries);
         UpdateStats(m_stats, m_stats2, m_session);
-        s_scatter.Invalidate();
+        IncludesChanged();
         m_graph->Refresh();
     }
     else if (event.GetId() == ID_EXCLUDE_SETTLE)
     {
         ExcludeSettling(m_session);
         UpdateStats(m_stats, m_stats2, m_session);
-        s_scatter.Invalidate();
+        IncludesChanged();
+        m_graph->Refresh();
+    }
+    else if (event.GetId() == ID_EXCLUDE_OUTLIERS)
+    {
+        ExcludeOutliers(m_session, s_settings.outliers);
+        UpdateStats(m_stats, m_stats2, m_session);
+        IncludesChanged();
         m_graph->Refresh();
     }
 }
 
+void LogViewFrame::OnMenuScatterDensity(wxCommandEvent& event)
+{
+    s_settings.scatterDensity = event.IsChecked();
+    Config->Write("/scatter/density", s_settings.scatterDensity);
+    s_scatter.Invalidate();
+    m_graph->Refresh();
+}
+
 void LogViewFrame::OnMenuAnalyzeGA(wxCommandEvent& event)
 {
     if (!m_analysisWin)
@@ -751,6 +1343,8 @@ HelpDialog::HelpDialog(wxWindow *parent) : HelpDialogBase(parent)
         << "To include a range of points from the statistics, hold down Shift and drag the mouse," << BR
         << "CTRL-Click on an excluded range to un-exclude the range of points." << BR
         << "Right-click on the graph for some more options." << BR
+        << "<h3>Troubleshooting</h3>"
+        << "F3 shows or hides the paint timings over the graph, Shift+F3 copies them to the clipboard" << BR
         << "</html>";
 
     m_html->SetPage(s);
@@ -775,17 +1369,17 @@ inline static void UpdateRange(GraphInfo *ginfo)
     ginfo->i1 = (double) (ginfo->xofs + ginfo->width) / ginfo->hscale;
 }
 
-void LogViewFrame::InitGraph()
+static void InitGraph(GuideSession *session)
 {
-    GraphInfo& ginfo = m_session->m_ginfo;
+    GraphInfo& ginfo = session->m_ginfo;
 
     // find max ra or dec
     double mxr = 0.0;
     double mxy = 0.0;
     int mxmass = 0;
     double mxsnr = 0.0;
-    //for (const auto& e : m_session->entries)
-    for (auto it = m_session->entries.begin(); it != m_session->entries.end(); ++it)
+    //for (const auto& e : session->entries)
+    for (auto it = session->entries.begin(); it != session->entries.end(); ++it)
     {
         const auto& e = *it;
 
@@ -815,9 +1409,10 @@ void LogViewFrame::InitGraph()
     ginfo.yofs = 0;
 }
 
-void LogViewFrame::InitCalDisplay()
+// fit the calibration to a graph of the given size
+static void InitCalDisplay(Calibration *cal, const wxSize& graphSize)
 {
-    CalDisplay& disp = m_calibration->display;
+    CalDisplay& disp = cal->display;
     disp.xofs = disp.yofs = 0;
 
     disp.firstWest = -1;
@@ -825,7 +1420,7 @@ void LogViewFrame::InitCalDisplay()
     double maxv = 0.0;
     int i = 0;
 
-    for (auto it = m_calibration->entries.begin(); it != m_calibration->entries.end(); ++it)
+    for (auto it = cal->entries.begin(); it != cal->entries.end(); ++it)
     {
         const auto& p = *it;
         if (p.direction == WEST)
@@ -847,7 +1442,7 @@ void LogViewFrame::InitCalDisplay()
 
     if (maxv == 0.0)
         maxv = 25.0;
-    int size = wxMin(m_graph->GetSize().GetWidth(), m_graph->GetSize().GetHeight());
+    int size = wxMin(graphSize.GetWidth(), graphSize.GetHeight());
     size = std::max(size, 40); // prevent -ive scale
     disp.scale = (double)(size - 30) / (2.0 * maxv);
     disp.min_scale = std::min(disp.scale, MIN_HSCALE_CAL);
@@ -855,6 +1450,22 @@ void LogViewFrame::InitCalDisplay()
     disp.valid = true;
 }
 
+void LogViewFrame::ShowGuideControls(bool show)
+{
+    if (m_mainSizer->IsShown(m_guideControlsSizer) == show)
+        return;
+
+    m_vplus->Enable(show);
+    m_vminus->Enable(show);
+    m_vreset->Enable(show);
+    m_vpan->Enable(show);
+    m_vlock->Enable(show);
+    m_scrollbar->Enable(show);
+
+    m_mainSizer->Show(m_guideControlsSizer, show);
+    m_mainSizer->Layout();
+}
+
 void LogViewFrame::OnCellSelected(wxGridEvent& event)
 {
     int row = event.GetRow();
@@ -910,21 +1521,9 @@ void LogViewFrame::OnCellSelected(wxGridEvent& event)
         {
             bool first = !m_session->m_ginfo.IsValid();
             if (first)
-                InitGraph();
+                InitGraph(m_session);
 
-            if (!m_mainSizer->IsShown(m_guideControlsSizer))
-            {
-                bool enable = true;
-                m_vplus->Enable(enable);
-                m_vminus->Enable(enable);
-                m_vreset->Enable(enable);
-                m_vpan->Enable(enable);
-                m_vlock->Enable(enable);
-                m_scrollbar->Enable(enable);
-
-                m_mainSizer->Show(m_guideControlsSizer);
-                m_mainSizer->Layout();
-            }
+            ShowGuideControls(true);
 
             InitStats(m_stats, m_stats2, m_session);
 
@@ -942,24 +1541,34 @@ void LogViewFrame::OnCellSelected(wxGridEvent& event)
         else
         {
             // do this first so InitCalDisplay has the right window sizes
-            if (m_mainSizer->IsShown(m_guideControlsSizer))
-            {
-                bool enable = false;
-                m_vplus->Enable(enable);
-                m_vminus->Enable(enable);
-                m_vreset->Enable(enable);
-                m_vpan->Enable(enable);
-                m_vlock->Enable(enable);
-                m_scrollbar->Enable(enable);
-
-                m_mainSizer->Hide(m_guideControlsSizer);
-                m_mainSizer->Layout();
-            }
+            ShowGuideControls(false);
 
             m_stats->ClearGrid();
             if (!m_calibration->display.valid)
-                InitCalDisplay();
+                InitCalDisplay(m_calibration, m_graph->GetSize());
+        }
+    }
+    else if (row == (int) s_log.sections.size() && !s_log.sessions.empty())
+    {
+        // whole log summary
+        m_session = 0;
+        m_calibration = 0;
+
+        // as for a calibration, so the shortcuts do not act on the hidden controls
+        ShowGuideControls(false);
+
+        s_log.CalcSummaryMAD();
+        const GuideSession& sum = s_log.summary;
+        {
+            wxWindowUpdateLocker lck(m_sessionInfo);
+            m_sessionInfo->Clear();
+            *m_sessionInfo << wxString::Format("Whole log: %u guiding sessions, %s\n", (unsigned int) s_log.sessions.size(), durStr(sum.duration));
+            *m_sessionInfo << wxString::Format("Pixel scale = %.2f arc-sec/px\n", sum.pixelScale);
+            *m_sessionInfo << "Drift is weighted by session duration, RMS and percentiles are over all included frames\n";
+            m_sessionInfo->SetInsertionPoint(0);
         }
+
+        InitStats(m_stats, m_stats2, &sum);
     }
     else
     {
@@ -970,6 +1579,7 @@ void LogViewFrame::OnCellSelected(wxGridEvent& event)
     }
 
     m_rowInfo->Clear();
+    s_rowInfoIdx = -1;
     s_scatter.Invalidate();
     m_graph->Refresh();
 
@@ -1045,7 +1655,8 @@ void LogViewFrame::OnLeftUp(wxMouseEvent& event)
             {
                 s_drag.m_mousePos[1] = event.GetPosition();
                 s_drag.m_mouseTime[1] = now;
-                m_timer.Start(20, true);
+                s_drag.m_residual = wxRealPoint(0.0, 0.0);
+                m_timer.Start(FRAME_MS, true);
             }
         }
     }
@@ -1072,7 +1683,15 @@ void LogViewFrame::OnLeftUp(wxMouseEvent& event)
 
                     for (int j = i0; j <= i1; j++)
                         entries[j].included = include;
-                    s_scatter.Invalidate();
+                    if (include)
+                    {
+                        s_selRange.session = m_session;
+                        s_selRange.begin = i0;
+                        s_selRange.end = i1 + 1;
+                    }
+                    else if (s_selRange.session == m_session)
+                        s_selRange = SelRange();
+                    IncludesChanged();
                     m_graph->Refresh();
                     UpdateStats(m_stats, m_stats2, m_session);
                 }
@@ -1096,7 +1715,7 @@ void LogViewFrame::OnLeftUp(wxMouseEvent& event)
                             break;
                         entries[j].included = true;
                     }
-                    s_scatter.Invalidate();
+                    IncludesChanged();
                     m_graph->Refresh();
                     UpdateStats(m_stats, m_stats2, m_session);
                 }
@@ -1117,8 +1736,9 @@ void LogViewFrame::OnMove(wxMouseEvent& event)
         {
             int i = IdxFromScreen(ginfo, event.GetPosition().x);
             const GuideSession::EntryVec& entries = m_session->entries;
-            if (i >= 0 && i < (int)entries.size())
+            if (i >= 0 && i < (int)entries.size() && i != s_rowInfoIdx)
             {
+                s_rowInfoIdx = i;
                 const GuideEntry& ent = entries[i];
                 wxDateTime t(m_session->starts + wxTimeSpan(0, 0, 0, (wxLongLong)(ent.dt * 1000.0)));
                 m_rowInfo->SetValue(wxString::Format("%s Frame %d t=%.2f (x,y)=(%.2f,%.2f) (RA,Dec)=(%.2f,%.2f) guide (%.2f,%.2f) corr (%d,%d) m=%d SNR=%.1f%s %s",
@@ -1200,7 +1820,7 @@ void LogViewFrame::OnMove(wxMouseEvent& event)
                 }
             }
 
-            m_graph->Refresh();
+            RequestPaint();
         }
         else // DRAG_EXCLUDE / DRAG_INCLUDE
         {
@@ -1208,7 +1828,7 @@ void LogViewFrame::OnMove(wxMouseEvent& event)
             wxPoint d = s_drag.m_endPoint - s_drag.m_anchorPoint;
             if (d.x > 2 || d.x < -2 || d.y > 2 || d.y < -2)
                 s_drag.dragMoved = true;
-            m_graph->Refresh();
+            RequestPaint();
         }
     }
     else if (m_calibration && s_drag.m_dragging)
@@ -1231,7 +1851,7 @@ void LogViewFrame::OnMove(wxMouseEvent& event)
             s_drag.m_mouseTime[1] = now;
         }
 
-        m_graph->Refresh();
+        RequestPaint();
     }
 
     event.Skip();
@@ -1243,12 +1863,17 @@ void LogViewFrame::OnCaptureLost(wxMouseCaptureLostEvent& evt)
     evt.Skip();
 }
 
+// Kinetic pan step. The timer is only a wake-up; movement and
+// deceleration follow the time actually elapsed since the last step.
 void LogViewFrame::OnTimer(wxTimerEvent& evt)
 {
     wxLongLong_t now = ::now();
     long dt = now - s_drag.m_mouseTime[1];
-    int dx = (int)floor(s_drag.m_rate.x * dt);
-    int dy = (int)floor(s_drag.m_rate.y * dt);
+    double mx = s_drag.m_rate.x * dt + s_drag.m_residual.x;
+    double my = s_drag.m_rate.y * dt + s_drag.m_residual.y;
+    int dx = (int)floor(mx);
+    int dy = (int)floor(my);
+    s_drag.m_residual = wxRealPoint(mx - dx, my - dy);
 
     wxPoint pos(s_drag.m_mousePos[1].x + dx, s_drag.m_mousePos[1].y + dy);
 
@@ -1262,18 +1887,19 @@ void LogViewFrame::OnTimer(wxTimerEvent& evt)
             ginfo.xofs = ginfo.xmax;
         UpdateRange(&ginfo);
         UpdateScrollbar();
-        m_graph->Refresh();
+        RequestPaint();
     }
     else if (m_calibration)
     {
         CalDisplay& disp = m_calibration->display;
         disp.xofs -= dx;
         disp.yofs -= dy;
-        m_graph->Refresh();
+        RequestPaint();
     }
 
-    double decel = s_drag.decel;
-    s_drag.decel += DECEL;
+    double const ticks = (double) dt / KINETIC_TICK;
+    double decel = s_drag.decel * ticks;
+    s_drag.decel += DECEL * ticks;
     if (s_drag.m_rate.x > decel)
         s_drag.m_rate.x -= decel;
     else if (s_drag.m_rate.x < -decel)
@@ -1292,10 +1918,26 @@ void LogViewFrame::OnTimer(wxTimerEvent& evt)
     {
         s_drag.m_mousePos[1] = pos;
         s_drag.m_mouseTime[1] = now;
-        m_timer.Start(20, true);
+        m_timer.Start(FRAME_MS, true);
     }
 }
 
+// Repaint the graph at most once per FRAME_MS. Requests arriving sooner
+// are merged into one repaint when the frame timer fires.
+void LogViewFrame::RequestPaint()
+{
+    long wait = (long)(m_lastPaint + FRAME_MS - ::now());
+    if (wait <= 0)
+        m_graph->Refresh();
+    else if (!m_frameTimer.IsRunning())
+        m_frameTimer.Start(wait, true);
+}
+
+void LogViewFrame::OnFrameTimer(wxTimerEvent& evt)
+{
+    m_graph->Refresh();
+}
+
 void LogViewFrame::OnScroll(wxScrollEvent& event)
 {
     if (!m_session)
@@ -1357,7 +1999,7 @@ void LogViewFrame::UpdateScrollbar()
     m_scrollbar->SetScrollbar(-p0, ginfo.width, p1 - p0, ginfo.width);
 }
 
-static void PaintCalibration(wxDC& dc, const Calibration *cal, wxWindow *graph)
+static void PaintCalibration(wxDC& dc, const Calibration *cal, const wxSize& graphSize)
 {
     dc.SetTextForeground(wxColour(80, 80, 80));
 #if defined(__WXOSX__)
@@ -1366,9 +2008,9 @@ static void PaintCalibration(wxDC& dc, const Calibration *cal, wxWindow *graph)
     dc.SetFont(wxSWISS_FONT->Smaller());
 #endif
 
-    int size = wxMin(graph->GetSize().GetWidth(), graph->GetSize().GetHeight());
-    int x0 = graph->GetSize().GetWidth() / 2 - cal->display.xofs;
-    int y0 = graph->GetSize().GetHeight() / 2 - cal->display.yofs;
+    int size = wxMin(graphSize.GetWidth(), graphSize.GetHeight());
+    int x0 = graphSize.GetWidth() / 2 - cal->display.xofs;
+    int y0 = graphSize.GetHeight() / 2 - cal->display.yofs;
 
     double const scale = cal->display.scale;
 
@@ -1437,327 +2079,510 @@ static void PaintCalibration(wxDC& dc, const Calibration *cal, wxWindow *graph)
     }
 }
 
-void LogViewFrame::OnPaintGraph(wxPaintEvent& event)
+// Screen position of entry i (fractional for the edges of bars). The
+// position within the session is rounded before the scroll offset is
+// applied, so scrolling moves everything by exactly xofs pixels and a
+// cached rendering can be shifted instead of redrawn.
+inline static int EntryX(const GraphInfo& ginfo, double i)
 {
-    wxAutoBufferedPaintDC dc(m_graph);
+    return (int) floor(i * ginfo.hscale) - ginfo.xofs;
+}
 
-    dc.Clear();
+// Call fn(x, i, j) for each screen column x holding entries [i, j) of
+// [i0, i1]. The range is widened to whole pixel columns so a partial
+// redraw gives the same result as a full one.
+template<typename F>
+static void ForEachColumn(const GuideSession::EntryVec& entries, const GraphInfo& ginfo, unsigned int i0, unsigned int i1, F fn)
+{
+    double const h = ginfo.hscale;
 
-    if (m_calibration)
+    while (i0 > 0 && floor((double)(i0 - 1) * h) == floor((double) i0 * h))
+        --i0;
+    while (i1 + 1 < entries.size() && floor((double)(i1 + 1) * h) == floor((double) i1 * h))
+        ++i1;
+
+    unsigned int i = i0;
+    while (i <= i1)
     {
-        PaintCalibration(dc, m_calibration, m_graph);
-        return;
-    }
+        double col_x = floor((double) i * h);
+        // first entry of the next pixel column
+        unsigned int j = (unsigned int) ceil((col_x + 1.0) / h);
+        while (j > i + 1 && floor((double)(j - 1) * h) > col_x)
+            --j;
+        while (j <= i1 && floor((double) j * h) == col_x)
+            ++j;
+        if (j <= i)
+            j = i + 1;
+        else if (j > i1 + 1)
+            j = i1 + 1;
 
-    if (!m_session)
-        return;
+        fn((int) col_x - ginfo.xofs, i, j);
 
-    const GuideSession::EntryVec& entries = m_session->entries;
-    const GraphInfo& ginfo = m_session->m_ginfo;
-    double const vscale = vscale_locked() ? get_vscale_setting(m_session->pixelScale) : ginfo.vscale;
+        i = j;
+    }
+}
+
+// Fill s_tmp with the points of column col of entries [i0, i1] when there
+// are several entries per pixel. Each pixel column gets a vertical stroke
+// from the min to the max of its entries, so at most two points per column
+// are drawn and no spike is lost. y = yorg + (int)(value * scale)
+static unsigned int DecimatedPoints(const MinMaxPyramid& lod, const GuideSession::EntryVec& entries, int col,
+                                    const GraphInfo& ginfo, unsigned int i0, unsigned int i1, int yorg, double scale)
+{
+    unsigned int ix = 0;
+    int prevy = 0;
+
+    ForEachColumn(entries, ginfo, i0, i1, [&](int x, unsigned int i, unsigned int j) {
+        float lo, hi;
+        lod.MinMax(entries, col, i, j, &lo, &hi);
+        int ya = yorg + (int)(lo * scale);
+        int yb = yorg + (int)(hi * scale);
+        // start at the end nearer to where the line already is
+        if (ix > 0 && abs(yb - prevy) < abs(ya - prevy))
+            std::swap(ya, yb);
+
+        wxASSERT(ix + 1 < s_tmp.size);
+        s_tmp.pts[ix].x = x;
+        s_tmp.pts[ix].y = ya;
+        ++ix;
+        if (yb != ya)
+        {
+            s_tmp.pts[ix].x = x;
+            s_tmp.pts[ix].y = yb;
+            ++ix;
+        }
+        prevy = yb;
+    });
+
+    return ix;
+}
+
+static std::vector<wxPoint> s_barPts;
+static std::vector<int> s_barCounts;
+
+static void AddBar(int x0, int x1, int ya, int yb)
+{
+    // the outline DrawRectangle would give for columns [x0, x1), rows [ya, yb)
+    s_barPts.push_back(wxPoint(x0, ya));
+    s_barPts.push_back(wxPoint(x1 - 1, ya));
+    s_barPts.push_back(wxPoint(x1 - 1, yb - 1));
+    s_barPts.push_back(wxPoint(x0, yb - 1));
+    s_barCounts.push_back(4);
+}
 
-    unsigned int i0, i1;
-    if (entries.size())
+static void AddStroke(int x, int ya, int yb)
+{
+    s_barPts.push_back(wxPoint(x, ya));
+    s_barPts.push_back(wxPoint(x, yb));
+    s_barCounts.push_back(2);
+}
+
+// Add the correction bars of entries [i0, i1] to dl as one set of polygons.
+// col is the pyramid column of the axis and device, the bar for entry i
+// starts at entry position i + xpos and spans y0 to y0 + (int)(duration * scale).
+// Bars narrower than a pixel become one vertical stroke per pixel column
+// covering the corrections in it, using the pyramid when there is one.
+// Returns the number of vertices added.
+static unsigned int DrawCorrections(DrawList& dl, const MinMaxPyramid *lod, const GuideSession::EntryVec& entries, int col,
+                            const GraphInfo& ginfo, unsigned int i0, unsigned int i1, double xpos, int cwid, int y0, double scale)
+{
+    s_barPts.clear();
+    s_barCounts.clear();
+
+    if (cwid >= 1)
     {
-        i0 = (unsigned int)std::max(ginfo.i0, 0.0);
-        i1 = std::min((size_t)ceil(ginfo.i1), entries.size() - 1);
+        for (unsigned int i = i0; i <= i1; i++)
+        {
+            int height = (int)(MinMaxPyramid::Value(entries[i], col) * scale);
+            if (height == 0)
+                continue;
+            int x = EntryX(ginfo, i + xpos);
+            if (height > 0)
+                AddBar(x, x + cwid, y0, y0 + height);
+            else
+                AddBar(x, x + cwid, y0 + height, y0);
+        }
+    }
+    else if (lod)
+    {
+        ForEachColumn(entries, ginfo, i0, i1, [&](int x, unsigned int i, unsigned int j) {
+            float lo, hi;
+            lod->MinMax(entries, col, i, j, &lo, &hi);
+            int ya = y0 + (int)(lo * scale);
+            int yb = y0 + (int)(hi * scale);
+            if (ya == y0 && yb == y0)
+                return;
+            AddStroke(x, std::min(std::min(ya, yb), y0), std::max(std::max(ya, yb), y0));
+        });
     }
     else
     {
-        i0 = 1;
-        i1 = 0;
+        for (unsigned int i = i0; i <= i1; i++)
+        {
+            int height = (int)(MinMaxPyramid::Value(entries[i], col) * scale);
+            if (height != 0)
+                AddStroke(EntryX(ginfo, i + xpos), y0, y0 + height);
+        }
     }
-    double x0 = (double)i0 * ginfo.hscale - (double)ginfo.xofs;
-    int fullw = m_graph->GetSize().GetWidth();
-    int y00 = m_graph->GetSize().GetHeight() / 2;
-    int y0 = y00 - ginfo.yofs;
-    unsigned int cnt = i1 >= i0 ? i1 - i0 + 1 : 0;
-    s_tmp.alloc(cnt);
 
-    bool const radec = m_axes->GetSelection() == 0;
+    if (!s_barCounts.empty())
+        dl.Polygons(s_barCounts.size(), &s_barCounts[0], &s_barPts[0]);
+    return (unsigned int) s_barPts.size();
+}
 
+void LogViewFrame::OnLodReady()
+{
+    if (m_session && m_session->m_ginfo.hscale < LOD_HSCALE)
+        m_graph->Refresh();
+}
+
+static void SetGraphFont(wxDC& dc)
+{
     dc.SetTextForeground(*wxLIGHT_GREY);
 #if defined(__WXOSX__)
     dc.SetFont(wxSMALL_FONT->Smaller());
 #else
     dc.SetFont(wxSWISS_FONT->Smaller());
 #endif
+}
 
-    dc.SetPen(*wxGREY_PEN);
-    dc.DrawLine(0, y0, fullw, y0);
+// dc for measuring text in the graph font while filling a draw list,
+// whatever the list is drawn on later
+static wxDC& GraphTextDC()
+{
+    static wxMemoryDC *s_dc;
+    if (!s_dc)
+    {
+        s_dc = new wxMemoryDC();
+        SetGraphFont(*s_dc);
+    }
+    return *s_dc;
+}
 
-    if (m_grid->IsChecked())
+// horizontal grid spacing, in display units (pixels or arc-seconds)
+// where vsc is screen pixels per display unit
+static double GridSpacing(double vsc, int height)
+{
+    double v = (double) height * (0.5 / 6.0) / vsc;
+    double m = pow(10, ceil(log10(v)));
+    double t;
+    if (v < (t = .25 * m))
+        v = t;
+    else if (v < (t = .5 * m))
+        v = t;
+    else
+        v = m;
+    return v;
+}
+
+// restrict the paint to screen columns [left, right)
+static void SetStrip(GraphPaint *gp, const GraphInfo& ginfo, size_t nentries, int left, int right)
+{
+    gp->left = left;
+    gp->right = right;
+
+    // a couple of entries either side for the lines and bars that cross the edges
+    double a = floor((double)(left + ginfo.xofs) / ginfo.hscale) - 2.0;
+    double b = ceil((double)(right + ginfo.xofs) / ginfo.hscale) + 2.0;
+    if (nentries == 0 || b < 0.0 || a > (double)(nentries - 1))
+    {
+        gp->i0 = 1;
+        gp->i1 = 0;
+        return;
+    }
+    gp->i0 = (unsigned int) std::max(a, 0.0);
+    gp->i1 = (unsigned int) std::min(b, (double)(nentries - 1));
+}
+
+// move the contents of bmp dx pixels to the right
+static void ScrollBitmap(wxBitmap& bmp, wxBitmap& scratch, int dx)
+{
+    if (!scratch.IsOk() || scratch.GetWidth() != bmp.GetWidth() || scratch.GetHeight() != bmp.GetHeight())
+        scratch.Create(bmp.GetWidth(), bmp.GetHeight());
     {
-        // horizontal grid lines
+        wxMemoryDC mdc(scratch);
+        mdc.DrawBitmap(bmp, dx, 0);
+    }
+    std::swap(bmp, scratch);
+}
+
+// grid, time ticks and limit lines
+static void PaintGraphBackground(DrawList& dl, const GraphPaint& gp)
+{
+    const GuideSession::EntryVec& entries = gp.session->entries;
+    const GraphInfo& ginfo = *gp.ginfo;
+    int const y0 = gp.y0;
+    double const vscale = gp.vscale;
+
+    // horizontal lines start at a multiple of 8 pixels from the session
+    // origin so the dot pattern lines up across scrolled strips
+    int const xl = gp.left - ((gp.left + ginfo.xofs) % 8 + 8) % 8;
+    int const xr = gp.right;
+
+    dl.SetPen(wxGREY_PEN->GetColour());
+    dl.Line(xl, y0, xr, y0);
+
+    if (gp.opts & GOPT_GRID)
+    {
+        // horizontal grid lines, labelled in the overlay
         double vsc = vscale;
-        bool const arcsecs = m_units->GetSelection() == 0;
-        if (arcsecs) // arc-seconds
-            vsc /= m_session->pixelScale;
-        double v = (double)m_graph->GetSize().GetHeight() * (0.5 / 6.0) / vsc;
-        double m = pow(10, ceil(log10(v)));
-        double t;
-        if (v < (t = .25 * m))
-            v = t;
-        else if (v < (t = .5 * m))
-            v = t;
-        else
-            v = m;
+        if (gp.opts & GOPT_ARCSECS)
+            vsc /= gp.session->pixelScale;
+        double v = GridSpacing(vsc, gp.height);
         int iv = (int)(v * vsc);
 
         if (iv > 0)
         {
-            dc.SetPen(wxPen(wxColour(100, 100, 100), 1, wxPENSTYLE_DOT));
-            double dy = v;
-            wxString format = arcsecs ? "%g\"" : "%g";
-            for (int y = y0 - iv; y > 0; y -= iv, dy += v)
-            {
-                dc.DrawLine(0, y, fullw, y);
-                dc.DrawText(wxString::Format(format, dy), 3, y + 2);
-            }
-            dy = -v;
-            for (int y = y0 + iv; y < m_graph->GetSize().GetHeight(); y += iv, dy -= v)
-            {
-                dc.DrawLine(0, y, fullw, y);
-                dc.DrawText(wxString::Format(format, dy), 3, y + 2);
-            }
+            dl.SetPen(wxColour(100, 100, 100), 1, wxPENSTYLE_DOT);
+            for (int y = y0 - iv; y > 0; y -= iv)
+                dl.Line(xl, y, xr, y);
+            for (int y = y0 + iv; y < gp.height; y += iv)
+                dl.Line(xl, y, xr, y);
         }
 
-        // vertical ticks
-        if (i1 > i0)
+        // vertical ticks, on a time scale fitted to the whole session so
+        // they do not move relative to the data when the graph is scrolled
+        size_t n = entries.size();
+        if (n > 1 && entries[n - 1].dt > entries[0].dt)
         {
-            double dt0 = m_session->entries[i0].dt;
-            double dt1 = m_session->entries[i1].dt;
-            double tspan = dt1 - dt0;
-            int x0 = (int)(((double)i0 + 0.5) * ginfo.hscale) - ginfo.xofs;
-            int x1 = (int)(((double)i1 + 0.5) * ginfo.hscale) - ginfo.xofs;
-            double r = (double)(x1 - x0) / tspan; // pixels per second
+            double tspan = entries[n - 1].dt - entries[0].dt;
+            double sx0 = 0.5 * ginfo.hscale;
+            double sx1 = ((double)(n - 1) + 0.5) * ginfo.hscale;
+            double r = (sx1 - sx0) / tspan; // pixels per second
             int secs = (int)(ceil(80.0 / (r * 60.0)) * 60.0); // seconds per tick
-            wxDateTime ti0(m_session->starts + wxTimeSpan(0, 0, 0, (wxLongLong)(dt0 * 1000.0)));
-            wxDateTime t0(ti0);
+
+            // times at the edges of the strip, leaving room for the label
+            // of a tick just left of it
+            double ta = std::max((gp.left - 80 + ginfo.xofs - sx0) / r, 0.0);
+            double tb = std::min((gp.right + ginfo.xofs - sx0) / r, tspan);
+
+            wxDateTime ti0(gp.session->starts + wxTimeSpan(0, 0, 0, (wxLongLong)(entries[0].dt * 1000.0)));
+            wxDateTime t0(ti0 + wxTimeSpan(0, 0, 0, (wxLongLong)(ta * 1000.0)));
             time_t ticks = ((t0.GetTicks() + secs - 1) / secs) * secs;
             t0.Set(ticks); // time of first tick
             double t = (double)(t0 - ti0).GetMilliseconds().GetValue() / 1000.0;
-            wxDateTime t1(m_session->starts + wxTimeSpan(0, 0, 0, (wxLongLong)(dt1 * 1000.0)));
-            double tend = (double)(t1 - ti0).GetMilliseconds().GetValue() / 1000.0;
 
-            dc.SetPen(*wxGREY_PEN);
-            for (; t < tend; t += secs)
+            dl.SetPen(wxGREY_PEN->GetColour());
+            for (; t < tb; t += secs)
             {
-                int x = (int)((double) x0 + r * t);
-                dc.DrawLine(x, 0, x, 10);
+                int x = (int) floor(sx0 + r * t) - ginfo.xofs;
+                dl.Line(x, 0, x, 10);
                 wxDateTime wxt(ti0 + wxTimeSpan(0, 0, 0, (wxLongLong)(t * 1000.0)));
-                dc.DrawText(wxt.Format("%H:%M"), x + 3, 1);
+                dl.Text(wxt.Format("%H:%M"), x + 3, 1);
             }
         }
     }
 
     // limits
-    if (m_limits->IsChecked())
+    if (gp.opts & GOPT_LIMITS)
     {
-        if (m_ra->IsChecked())
+        if (gp.opts & GOPT_RA)
         {
-            if (m_session->mount.xlim.maxDur > 0.0)
+            if (gp.session->mount.xlim.maxDur > 0.0)
             {
                 // max ra (milliseconds) * xRate (px/sec)
-                int y = (int)(m_session->mount.xlim.maxDur * m_session->mount.xRate / 1000.0 * vscale);
-                dc.SetPen(wxPen(s_settings.raColor, 1, wxPENSTYLE_DOT));
-                dc.DrawLine(0, y0 - y, fullw, y0 - y);
-                dc.DrawLine(0, y0 + y, fullw, y0 + y);
+                int y = (int)(gp.session->mount.xlim.maxDur * gp.session->mount.xRate / 1000.0 * vscale);
+                dl.SetPen(s_settings.raColor, 1, wxPENSTYLE_DOT);
+                dl.Line(xl, y0 - y, xr, y0 - y);
+                dl.Line(xl, y0 + y, xr, y0 + y);
             }
-            if (m_session->mount.xlim.minMo > 0.0)
+            if (gp.session->mount.xlim.minMo > 0.0)
             {
                 // minMo (pixels)
-                int y = (int)(m_session->mount.xlim.minMo * vscale);
-                dc.SetPen(wxPen(s_settings.raColor, 1, wxPENSTYLE_DOT));
-                dc.DrawLine(0, y0 - y, fullw, y0 - y);
-                dc.DrawLine(0, y0 + y, fullw, y0 + y);
+                int y = (int)(gp.session->mount.xlim.minMo * vscale);
+                dl.SetPen(s_settings.raColor, 1, wxPENSTYLE_DOT);
+                dl.Line(xl, y0 - y, xr, y0 - y);
+                dl.Line(xl, y0 + y, xr, y0 + y);
             }
         }
-        if (m_dec->IsChecked())
+        if (gp.opts & GOPT_DEC)
         {
-            if (m_session->mount.ylim.maxDur > 0.0)
+            if (gp.session->mount.ylim.maxDur > 0.0)
             {
                 // max dec (milliseconds) * yRate (px/sec)
-                int y = (int)(m_session->mount.ylim.maxDur * m_session->mount.yRate / 1000.0 * vscale);
-                dc.SetPen(wxPen(s_settings.decColor, 1, wxPENSTYLE_DOT));
-                dc.DrawLine(0, y0 - y, fullw, y0 - y);
-                dc.DrawLine(0, y0 + y, fullw, y0 + y);
+                int y = (int)(gp.session->mount.ylim.maxDur * gp.session->mount.yRate / 1000.0 * vscale);
+                dl.SetPen(s_settings.decColor, 1, wxPENSTYLE_DOT);
+                dl.Line(xl, y0 - y, xr, y0 - y);
+                dl.Line(xl, y0 + y, xr, y0 + y);
             }
-            if (m_session->mount.ylim.minMo > 0.0)
+            if (gp.session->mount.ylim.minMo > 0.0)
             {
                 // minMo (pixels)
-                int y = (int)(m_session->mount.ylim.minMo * vscale);
-                dc.SetPen(wxPen(s_settings.decColor, 1, wxPENSTYLE_DOT));
-                dc.DrawLine(0, y0 - y, fullw, y0 - y);
-                dc.DrawLine(0, y0 + y, fullw, y0 + y);
+                int y = (int)(gp.session->mount.ylim.minMo * vscale);
+                dl.SetPen(s_settings.decColor, 1, wxPENSTYLE_DOT);
+                dl.Line(xl, y0 - y, xr, y0 - y);
+                dl.Line(xl, y0 + y, xr, y0 + y);
             }
         }
     }
 
+    gp.profile->Mark("grid");
+}
+
+// guide corrections, star mass and SNR, and the RA/Dec curves
+static void PaintGraphData(DrawList& dl, const GraphPaint& gp)
+{
+    const GuideSession::EntryVec& entries = gp.session->entries;
+    const GraphInfo& ginfo = *gp.ginfo;
+    unsigned int const i0 = gp.i0, i1 = gp.i1;
+    int const y00 = gp.y00, y0 = gp.y0;
+    double const vscale = gp.vscale;
+    bool const radec = gp.radec;
+    const MinMaxPyramid *lod = gp.lod;
+
+    unsigned int cnt = i1 >= i0 ? i1 - i0 + 1 : 0;
+    // decimated series have at most 2 points for every 2 or more entries,
+    // plus the partial columns at each end
+    s_tmp.alloc(cnt + 4);
+
     // corrections
     int cwid = ((int)ginfo.hscale * .8);
 
-    WhichMount device = m_device->GetSelection() == 0 ? MOUNT : AO;
+    WhichMount device = (gp.opts & GOPT_MOUNT) ? MOUNT : AO;
 
     // ra corrections
-    if (m_corrections->IsChecked() && m_ra->IsChecked() && cwid >= 1)
+    if ((gp.opts & GOPT_CORRECTIONS) && (gp.opts & GOPT_RA) && i1 >= i0)
     {
-        wxString lblE(_("GuideEast"));
-        static wxSize szE;
-        if (szE.x == 0)
-            szE = dc.GetTextExtent(lblE);
-        wxColor prev = dc.GetTextForeground();
-        dc.SetTextForeground(s_settings.raColor.ChangeLightness(75));
-        dc.DrawText(lblE, fullw - szE.GetWidth() - 4, m_graph->GetSize().GetHeight() - 2 * szE.GetHeight() - 2);
-        dc.SetTextForeground(prev);
-
-        dc.SetBrush(*wxTRANSPARENT_BRUSH);
-        dc.SetPen(wxPen(s_settings.raColor.ChangeLightness(60)));
-
-        double xRate[2];
-        xRate[MOUNT] = m_session->mount.xRate / 1000.0; // pixels per millisec
-        xRate[AO] = m_session->ao.xRate / 1000.0;
-
-        double xx = x0 - 0.4 * ginfo.hscale;
-        for (unsigned int i = i0; i <= i1; i++)
-        {
-            int x = (int) xx;
-            const auto& e = entries[i];
-
-            if (e.mount == device)
-            {
-                int height = (int)(e.radur * xRate[e.mount] * vscale);
-                if (height > 0)
-                    dc.DrawRectangle(x, y0, cwid, height);
-                else if (height < 0)
-                    dc.DrawRectangle(x, y0 + height, cwid, -height);
-            }
+        dl.SetPen(s_settings.raColor.ChangeLightness(60));
 
-            xx += ginfo.hscale;
-        }
+        const Mount& mount = device == MOUNT ? gp.session->mount : gp.session->ao;
+        double xRate = mount.xRate / 1000.0; // pixels per millisec
+        gp.profile->AddPoints(DrawCorrections(dl, lod, entries, device == MOUNT ? MinMaxPyramid::COL_RADUR_MOUNT : MinMaxPyramid::COL_RADUR_AO,
+                                            ginfo, i0, i1, -0.4, cwid, y0, xRate * vscale));
     }
 
     // dec corrections
-    if (m_corrections->IsChecked() && m_dec->IsChecked() && cwid >= 1)
+    if ((gp.opts & GOPT_CORRECTIONS) && (gp.opts & GOPT_DEC) && i1 >= i0)
     {
-        wxString lblN(_("GuideNorth"));
-        static wxSize szN;
-        if (szN.x == 0)
-            szN = dc.GetTextExtent(lblN);
-        wxColor prev = dc.GetTextForeground();
-        dc.SetTextForeground(s_settings.decColor.ChangeLightness(75));
-        dc.DrawText(lblN, fullw - szN.GetWidth() - 4, 0 /*topEdge*/ + szN.GetHeight() + 2);
-        dc.SetTextForeground(prev);
-
-        dc.SetBrush(*wxTRANSPARENT_BRUSH);
-        dc.SetPen(wxPen(s_settings.decColor.ChangeLightness(60)));
-
-        double yRate[2];
-        yRate[MOUNT] = m_session->mount.yRate / 1000.0; // pixels per millisec
-        yRate[AO] = m_session->ao.yRate / 1000.0;
+        dl.SetPen(s_settings.decColor.ChangeLightness(60));
 
-        double xx = x0 - 0.2 * ginfo.hscale;
-        for (unsigned int i = i0; i <= i1; i++)
-        {
-            int x = (int) xx;
-            const auto& e = entries[i];
-
-            if (e.mount == device)
-            {
-                int height = -(int)(e.decdur * yRate[e.mount] * vscale);
-                if (height > 0)
-                    dc.DrawRectangle(x, y0, cwid, height);
-                else if (height < 0)
-                    dc.DrawRectangle(x, y0 + height, cwid, -height);
-            }
-
-            xx += ginfo.hscale;
-        }
+        const Mount& mount = device == MOUNT ? gp.session->mount : gp.session->ao;
+        double yRate = mount.yRate / 1000.0; // pixels per millisec
+        gp.profile->AddPoints(DrawCorrections(dl, lod, entries, device == MOUNT ? MinMaxPyramid::COL_DECDUR_MOUNT : MinMaxPyramid::COL_DECDUR_AO,
+                                            ginfo, i0, i1, -0.2, cwid, y0, -yRate * vscale));
     }
 
-    if (m_mass->IsChecked())
+    gp.profile->Mark("corrections");
+
+    if (gp.opts & GOPT_MASS)
     {
         double massscale;
         if (ginfo.max_mass > 0)
-            massscale = (double)(m_graph->GetSize().GetHeight() / 2 - 10) / (double)ginfo.max_mass;
+            massscale = (double)(gp.height / 2 - 10) / (double)ginfo.max_mass;
         else
             massscale = 1.0;
 
         unsigned int ix = 0;
-        double x = x0;
-        for (unsigned int i = i0; i <= i1; i++)
+        if (lod)
+            ix = DecimatedPoints(*lod, entries, MinMaxPyramid::COL_MASS, ginfo, i0, i1, y00, -massscale);
+        else
         {
-            s_tmp.pts[ix].x = (int)x;
-            s_tmp.pts[ix].y = y00 - (int)(entries[i].mass * massscale);
+            for (unsigned int i = i0; i <= i1; i++)
+            {
+                s_tmp.pts[ix].x = EntryX(ginfo, i);
+                s_tmp.pts[ix].y = y00 - (int)(entries[i].mass * massscale);
 
-            ++ix;
-            x += ginfo.hscale;
+                ++ix;
+            }
         }
-        dc.SetPen(*wxYELLOW_PEN);
-        dc.DrawLines(ix, s_tmp.pts);
+        dl.SetPen(*wxYELLOW);
+        dl.Lines(ix, s_tmp.pts);
+        gp.profile->AddPoints(ix);
     }
 
-    if (m_snr->IsChecked())
+    if (gp.opts & GOPT_SNR)
     {
         double snrscale;
         if (ginfo.max_snr > 0.0)
-            snrscale = (double)(m_graph->GetSize().GetHeight() / 2 - 10) / ginfo.max_snr;
+            snrscale = (double)(gp.height / 2 - 10) / ginfo.max_snr;
         else
             snrscale = 1.0;
 
         unsigned int ix = 0;
-        double x = x0;
-        for (unsigned int i = i0; i <= i1; i++)
+        if (lod)
+            ix = DecimatedPoints(*lod, entries, MinMaxPyramid::COL_SNR, ginfo, i0, i1, y00, -snrscale);
+        else
         {
-            s_tmp.pts[ix].x = (int)x;
-            s_tmp.pts[ix].y = y00 - (int)(entries[i].snr * snrscale);
+            for (unsigned int i = i0; i <= i1; i++)
+            {
+                s_tmp.pts[ix].x = EntryX(ginfo, i);
+                s_tmp.pts[ix].y = y00 - (int)(entries[i].snr * snrscale);
 
-            ++ix;
-            x += ginfo.hscale;
+                ++ix;
+            }
         }
-        dc.SetPen(*wxWHITE_PEN);
-        dc.DrawLines(ix, s_tmp.pts);
+        dl.SetPen(*wxWHITE);
+        dl.Lines(ix, s_tmp.pts);
+        gp.profile->AddPoints(ix);
     }
 
     // Ra
-    if (m_ra->IsChecked())
+    if (gp.opts & GOPT_RA)
     {
         unsigned int ix = 0;
-        double x = x0;
-        for (unsigned int i = i0; i <= i1; i++)
+        if (lod)
+            ix = DecimatedPoints(*lod, entries, radec ? MinMaxPyramid::COL_RA : MinMaxPyramid::COL_DX, ginfo, i0, i1, y0, vscale);
+        else
         {
-            wxASSERT(ix < s_tmp.size);
-            s_tmp.pts[ix].x = (int)x;
-            double val = radec ? entries[i].raraw : entries[i].dx;
-            s_tmp.pts[ix].y = y0 + (int)(val * vscale);
+            for (unsigned int i = i0; i <= i1; i++)
+            {
+                wxASSERT(ix < s_tmp.size);
+                s_tmp.pts[ix].x = EntryX(ginfo, i);
+                double val = radec ? entries[i].raraw : entries[i].dx;
+                s_tmp.pts[ix].y = y0 + (int)(val * vscale);
 
-            ++ix;
-            x += ginfo.hscale;
+                ++ix;
+            }
         }
-        wxPen raOrDxPen(s_settings.raColor, ginfo.hscale < 2.0 ? 1 : 2);
-        dc.SetPen(raOrDxPen);
-        dc.DrawLines(ix, s_tmp.pts);
+        dl.SetPen(s_settings.raColor, ginfo.hscale < 2.0 ? 1 : 2);
+        dl.Lines(ix, s_tmp.pts);
+        gp.profile->AddPoints(ix);
     }
 
     // Dec
-    if (m_dec->IsChecked())
+    if (gp.opts & GOPT_DEC)
     {
         unsigned int ix = 0;
-        double x = x0;
-        for (unsigned int i = i0; i <= i1; i++)
+        if (lod)
+        {
+            // dec is drawn inverted, dy is not
+            if (radec)
+                ix = DecimatedPoints(*lod, entries, MinMaxPyramid::COL_DEC, ginfo, i0, i1, y0, -vscale);
+            else
+                ix = DecimatedPoints(*lod, entries, MinMaxPyramid::COL_DY, ginfo, i0, i1, y0, vscale);
+        }
+        else
         {
-            s_tmp.pts[ix].x = (int)x;
-            double val = radec ? -entries[i].decraw : entries[i].dy;
-            s_tmp.pts[ix].y = y0 + (int)(val * vscale);
+            for (unsigned int i = i0; i <= i1; i++)
+            {
+                s_tmp.pts[ix].x = EntryX(ginfo, i);
+                double val = radec ? -entries[i].decraw : entries[i].dy;
+                s_tmp.pts[ix].y = y0 + (int)(val * vscale);
 
-            ++ix;
-            x += ginfo.hscale;
+                ++ix;
+            }
         }
-        wxPen decOrDyPen(s_settings.decColor, ginfo.hscale < 2.0 ? 1 : 2);
-        dc.SetPen(decOrDyPen);
-        dc.DrawLines(ix, s_tmp.pts);
+        dl.SetPen(s_settings.decColor, ginfo.hscale < 2.0 ? 1 : 2);
+        dl.Lines(ix, s_tmp.pts);
+        gp.profile->AddPoints(ix);
     }
 
+    gp.profile->Mark("curves");
+}
+
+// shade screen columns [x0, x1] of an excluded range
+static void FillExcluded(DrawList& dl, const GraphPaint& gp, int x0, int x1)
+{
+    dl.Fill(x0, 0, x1 - x0 + 1, gp.height, wxColour(192, 192, 192, 64));
+}
+
+// excluded sections and event labels
+static void PaintGraphAnnotations(DrawList& dl, const GraphPaint& gp)
+{
+    const GuideSession::EntryVec& entries = gp.session->entries;
+    const GraphInfo& ginfo = *gp.ginfo;
+    unsigned int const i0 = gp.i0, i1 = gp.i1;
+
     // excluded sections
     if (i1 >= i0)
     {
@@ -1765,25 +2590,13 @@ void LogViewFrame::OnPaintGraph(wxPaintEvent& event)
         bool prev_included = included;
         unsigned int e0 = i0;
 
-        wxGraphicsContext *gc = 0;
         for (unsigned int i = i0 + 1; i <= i1; i++)
         {
             bool included = entries[i].included;
             if (included && !prev_included)
             {
                 // end of an excluded range, draw it
-                if (!gc)
-                {
-                    gc = wxGraphicsContext::Create(dc);
-                    if (gc)
-                        gc->SetBrush(wxColour(192, 192, 192, 64));
-                }
-                if (gc)
-                {
-                    int x0 = (int)((double)(e0 - 0.25) * ginfo.hscale) - ginfo.xofs;
-                    int x1 = (int)((double)(i - 1.0 + 0.25) * ginfo.hscale) - ginfo.xofs;
-                    gc->DrawRectangle(x0, 0, x1 - x0 + 1, m_graph->GetSize().GetHeight());
-                }
+                FillExcluded(dl, gp, EntryX(ginfo, e0 - 0.25), EntryX(ginfo, i - 1.0 + 0.25));
             }
             else if (!included && prev_included)
             {
@@ -1793,134 +2606,661 @@ void LogViewFrame::OnPaintGraph(wxPaintEvent& event)
             prev_included = included;
         }
         if (!prev_included)
+            FillExcluded(dl, gp, EntryX(ginfo, e0 - 0.25), EntryX(ginfo, i1 + 0.25));
+    }
+
+    gp.profile->Mark("exclusions");
+
+    // events
+    if (gp.opts & GOPT_EVENTS)
+    {
+        EventLabels& lbl = s_eventLabels;
+        lbl.Update(GraphTextDC(), gp.session, ginfo.hscale);
+
+        const GuideSession::InfoVec& infos = gp.session->infos;
+        for (size_t k = lbl.FirstReaching(gp.left + ginfo.xofs); k < infos.size(); k++)
         {
-            if (!gc)
-            {
-                gc = wxGraphicsContext::Create(dc);
-                if (gc)
-                    gc->SetBrush(wxColour(192, 192, 192, 64));
-            }
-            if (gc)
-            {
-                int x0 = (int)((double)(e0 - 0.25) * ginfo.hscale) - ginfo.xofs;
-                int x1 = (int)((double)(i1 + 0.25) * ginfo.hscale) - ginfo.xofs;
-                gc->DrawRectangle(x0, 0, x1 - x0 + 1, m_graph->GetSize().GetHeight());
-            }
+            if (infos[k].idx > (int) i1)
+                break;
+            int xpos = lbl.xpos[k] - ginfo.xofs;
+            if (xpos >= gp.right)
+                break;
+            if (xpos + lbl.width[k] <= gp.left)
+                continue;
+            dl.Text(lbl.text[k], xpos, gp.height - 16 * lbl.row[k]);
         }
+    }
+
+    gp.profile->Mark("events");
+}
+
+// Bin the included entries into an h x h count histogram centered on the
+// origin, in parallel with one histogram per chunk of entries. Returns
+// the counts, valid until the next call.
+static const unsigned int *ScatterHistogram(const GuideSession::EntryVec& entries, bool radec, double scale, int h)
+{
+    static std::vector<unsigned int> s_hist;
+
+    size_t const CHUNK = 65536;
+    size_t const n = entries.size();
+    size_t const nbins = (size_t) h * h;
+    size_t nchunks = std::max(std::min((size_t) WorkerCount(), (n + CHUNK - 1) / CHUNK), (size_t) 1);
+    size_t const per = (n + nchunks - 1) / nchunks;
 
-        delete gc;
+    s_hist.assign(nchunks * nbins, 0);
+
+    ParallelFor(nchunks, [&](size_t k) {
+        unsigned int *hist = &s_hist[k * nbins];
+        size_t end = std::min(n, (k + 1) * per);
+        for (size_t i = k * per; i < end; i++)
+        {
+            const GuideEntry& e = entries[i];
+            if (!e.included)
+                continue;
+            int x = h / 2 + (int)((double)(radec ? e.raraw : e.dx) * scale);
+            int y = h / 2 - (int)((double)(radec ? e.decraw : e.dy) * scale);
+            if (x >= 0 && x < h && y >= 0 && y < h)
+                ++hist[(size_t) y * h + x];
+        }
+    });
+
+    // fold the per-chunk counts into the first histogram
+    unsigned int *hist = &s_hist[0];
+    for (size_t k = 1; k < nchunks; k++)
+    {
+        const unsigned int *src = &s_hist[k * nbins];
+        for (size_t i = 0; i < nbins; i++)
+            hist[i] += src[i];
     }
 
-    // events
-    if (m_events->IsChecked())
+    return hist;
+}
+
+// Render the scatter plot of the included entries straight into the
+// pixels of img (h x h). In density mode each pixel is coloured by the log
+// of the number of points on it, otherwise every occupied pixel is yellow.
+static void RenderScatter(wxImage& img, const GuideSession::EntryVec& entries, bool radec, double scale, bool density)
+{
+    int const h = img.GetWidth();
+    unsigned char *px = img.GetData();
+
+    // black with a grey frame and axes
+    memset(px, 0, (size_t) h * h * 3);
+    for (int i = 0; i < h; i++)
+    {
+        int const pos[4][2] = { { i, 0 }, { i, h - 1 }, { 0, i }, { h - 1, i } };
+        for (int k = 0; k < 4; k++)
+            memset(px + ((size_t) pos[k][1] * h + pos[k][0]) * 3, 128, 3);
+        memset(px + ((size_t) i * h + h / 2) * 3, 128, 3);
+        memset(px + ((size_t)(h / 2) * h + i) * 3, 128, 3);
+    }
+
+    const unsigned int *hist = ScatterHistogram(entries, radec, scale, h);
+    size_t const nbins = (size_t) h * h;
+
+    unsigned int maxcnt = 0;
+    if (density)
+        for (size_t i = 0; i < nbins; i++)
+            maxcnt = std::max(maxcnt, hist[i]);
+    double const lmax = log(1.0 + (double) maxcnt);
+
+    for (size_t i = 0; i < nbins; i++)
     {
-        int i1 = std::min((int)entries.size(), (int)floor(ginfo.i1));
-        const GuideSession::InfoVec& infos = m_session->infos;
-        int prev_end = -999999;
-        int row = 1;
-        for (auto it = infos.begin(); it != infos.end(); ++it)
+        if (!hist[i])
+            continue;
+        unsigned char *p = px + i * 3;
+        if (!density || lmax <= 0.0)
         {
-            const auto& info = *it;
-            if (info.idx > i1)
-                break;
-            wxString s = info.repeats > 1 ? wxString::Format("%d x %s", info.repeats, info.info) : wxString(info.info);
-            int width = dc.GetTextExtent(s).x;
-            int xpos = info.idx * ginfo.hscale - ginfo.xofs;
-            if (info.idx <= (int)i0)
+            p[0] = 255; p[1] = 255; p[2] = 0;
+            continue;
+        }
+        // black-red-yellow-white, starting a little above black so single
+        // points stay visible
+        double t = 0.15 + 0.85 * log(1.0 + (double) hist[i]) / lmax;
+        p[0] = (unsigned char)(255.0 * std::min(1.0, 3.0 * t));
+        p[1] = (unsigned char)(255.0 * std::min(1.0, std::max(0.0, 3.0 * t - 1.0)));
+        p[2] = (unsigned char)(255.0 * std::min(1.0, std::max(0.0, 3.0 * t - 2.0)));
+    }
+}
+
+// The scatter plot of the session as an h x h bitmap, scaled like the
+// guide graph of the given height, with an ellipse showing the elongation.
+static wxBitmap ScatterBitmap(const GuideSession& session, int h, double vscale, int height, bool radec)
+{
+    double scale = vscale * h * 0.5 / (double)(height / 2 - 10);
+
+    wxImage img(h, h, false);
+    RenderScatter(img, session.entries, radec, scale, s_settings.scatterDensity);
+    wxBitmap bmp(img);
+
+    wxMemoryDC mdc(bmp);
+
+    // draw an ellipse showing the elongation
+    {
+        double const expand = 3.0;
+        double ew = session.lx * scale * expand;
+        double ehw = ew * 0.5;
+        double eh = session.ly * scale * expand;
+        double ehh = eh * 0.5;
+
+        wxGraphicsContext *gc = wxGraphicsContext::Create(mdc);
+        if (gc)
+        {
+            gc->Translate(h / 2 + session.avg_ra * scale, h / 2 - session.avg_dec * scale);
+            gc->Rotate(-session.theta);
+
+            gc->SetPen(wxPen(wxColour(255, 32, 255), 1));
+            gc->DrawEllipse(-ehw, -ehh, ew, eh);
+            gc->StrokeLine(-ehw * 1.5, 0.0, ehw * 1.5, 0.0);
+            gc->StrokeLine(0.0, -ehh * 1.5, 0.0, ehh * 1.5);
+
+            delete gc;
+        }
+    }
+
+    mdc.SelectObject(wxNullBitmap);
+    return bmp;
+}
+
+// grid line labels and corrections legend, at fixed screen positions
+static void PaintGraphLabels(DrawList& dl, const GraphPaint& gp)
+{
+    wxDC& tdc = GraphTextDC();
+    double const vscale = gp.vscale;
+    int const fullw = gp.width;
+    int const y0 = gp.y0;
+
+    // horizontal grid line labels
+    if (gp.opts & GOPT_GRID)
+    {
+        double vsc = vscale;
+        bool const arcsecs = (gp.opts & GOPT_ARCSECS) != 0;
+        if (arcsecs)
+            vsc /= gp.session->pixelScale;
+        double v = GridSpacing(vsc, gp.height);
+        int iv = (int)(v * vsc);
+
+        if (iv > 0)
+        {
+            double dy = v;
+            wxString format = arcsecs ? "%g\"" : "%g";
+            for (int y = y0 - iv; y > 0; y -= iv, dy += v)
+                dl.Text(wxString::Format(format, dy), 3, y + 2);
+            dy = -v;
+            for (int y = y0 + iv; y < gp.height; y += iv, dy -= v)
+                dl.Text(wxString::Format(format, dy), 3, y + 2);
+        }
+    }
+
+    // corrections legend
+    if ((gp.opts & GOPT_CORRECTIONS) && (gp.opts & GOPT_RA))
+    {
+        wxString lblE(_("GuideEast"));
+        static wxSize szE;
+        if (szE.x == 0)
+            szE = tdc.GetTextExtent(lblE);
+        dl.SetTextColour(s_settings.raColor.ChangeLightness(75));
+        dl.Text(lblE, fullw - szE.GetWidth() - 4, gp.height - 2 * szE.GetHeight() - 2);
+        dl.SetTextColour(*wxLIGHT_GREY);
+    }
+    if ((gp.opts & GOPT_CORRECTIONS) && (gp.opts & GOPT_DEC))
+    {
+        wxString lblN(_("GuideNorth"));
+        static wxSize szN;
+        if (szN.x == 0)
+            szN = tdc.GetTextExtent(lblN);
+        dl.SetTextColour(s_settings.decColor.ChangeLightness(75));
+        dl.Text(lblN, fullw - szN.GetWidth() - 4, 0 /*topEdge*/ + szN.GetHeight() + 2);
+        dl.SetTextColour(*wxLIGHT_GREY);
+    }
+}
+
+void LogViewFrame::OnPaintGraph(wxPaintEvent& event)
+{
+    wxAutoBufferedPaintDC dc(m_graph);
+    m_lastPaint = ::now();
+
+    if (m_calibration)
+    {
+        dc.Clear();
+        PaintCalibration(dc, m_calibration, m_graph->GetSize());
+        return;
+    }
+
+    if (!m_session)
+    {
+        dc.Clear();
+        return;
+    }
+
+    m_profile.Begin();
+
+    const GuideSession::EntryVec& entries = m_session->entries;
+    const GraphInfo& ginfo = m_session->m_ginfo;
+
+    GraphPaint gp;
+    gp.session = m_session;
+    gp.ginfo = &ginfo;
+    gp.profile = &m_profile;
+    gp.vscale = vscale_locked() ? get_vscale_setting(m_session->pixelScale) : ginfo.vscale;
+    gp.width = m_graph->GetSize().GetWidth();
+    gp.height = m_graph->GetSize().GetHeight();
+    gp.y00 = gp.height / 2;
+    gp.y0 = gp.y00 - ginfo.yofs;
+    gp.radec = m_axes->GetSelection() == 0;
+    // zoomed out, the series are drawn from the min/max pyramid once it is built
+    gp.lod = ginfo.hscale < LOD_HSCALE ? s_lod.Get(this, m_session) : nullptr;
+    gp.opts =
+        (m_grid->IsChecked() ? GOPT_GRID : 0) |
+        (m_limits->IsChecked() ? GOPT_LIMITS : 0) |
+        (m_ra->IsChecked() ? GOPT_RA : 0) |
+        (m_dec->IsChecked() ? GOPT_DEC : 0) |
+        (ArcsecsSelected() ? GOPT_ARCSECS : 0) |
+        (m_corrections->IsChecked() ? GOPT_CORRECTIONS : 0) |
+        (m_mass->IsChecked() ? GOPT_MASS : 0) |
+        (m_snr->IsChecked() ? GOPT_SNR : 0) |
+        (gp.radec ? GOPT_RADEC : 0) |
+        (m_device->GetSelection() == 0 ? GOPT_MOUNT : 0) |
+        (m_events->IsChecked() ? GOPT_EVENTS : 0);
+
+    GraphLayerKey key;
+    key.session = m_session;
+    key.width = gp.width;
+    key.height = gp.height;
+    key.hscale = ginfo.hscale;
+    key.vscale = gp.vscale;
+    key.xofs = ginfo.xofs;
+    key.yofs = ginfo.yofs;
+    key.opts = gp.opts;
+    key.raColor = s_settings.raColor.GetRGB();
+    key.decColor = s_settings.decColor.GetRGB();
+    key.lod = gp.lod;
+    key.includeGen = s_includeGen;
+
+    // re-render the layers from the lowest one whose inputs changed; each
+    // starts from a copy of the one below. When only the horizontal offset
+    // changed the layer is shifted and just the exposed strip is drawn.
+    bool redraw = false;
+    for (int layer = 0; layer < NUM_LAYERS; layer++)
+    {
+        GraphLayerKey lkey = key.ForLayer(layer);
+        const GraphLayerKey& prev = s_layers.key[layer];
+
+        wxBitmap& bmp = s_layers.bmp[layer];
+        int left = 0, right = gp.width;
+
+        if (!redraw && s_layers.valid[layer])
+        {
+            if (prev == lkey)
+                continue;
+
+            int dx = prev.xofs - lkey.xofs;
+            if (prev.SameExceptOffset(lkey) && abs(dx) < gp.width)
             {
-                if (xpos + width <= 0)
-                    continue;
+                ScrollBitmap(bmp, s_layers.scratch, dx);
+                if (dx > 0)
+                    right = dx;
+                else
+                    left = gp.width + dx;
             }
-            if (xpos < prev_end + 10)
-                ++row;
             else
-                row = 1;
-            if (xpos + width > prev_end)
-                prev_end = xpos + width;
-            dc.DrawText(s, xpos, m_graph->GetSize().GetHeight() - 16 * row);
+                redraw = true;
         }
+        else
+            redraw = true;
+
+        if (redraw && (!bmp.IsOk() || bmp.GetWidth() != gp.width || bmp.GetHeight() != gp.height))
+            bmp.Create(std::max(gp.width, 1), std::max(gp.height, 1));
+
+        SetStrip(&gp, ginfo, entries.size(), left, right);
+
+        DrawList& dl = s_layers.list[layer];
+        dl.Clear();
+        switch (layer) {
+        case LAYER_BACKGROUND: PaintGraphBackground(dl, gp); break;
+        case LAYER_DATA: PaintGraphData(dl, gp); break;
+        case LAYER_ANNOTATIONS: PaintGraphAnnotations(dl, gp); break;
+        }
+
+        wxMemoryDC mdc(bmp);
+        mdc.SetClippingRegion(left, 0, right - left, gp.height);
+        if (layer == LAYER_BACKGROUND)
+        {
+            wxColour bg(m_graph->GetBackgroundColour());
+            mdc.SetPen(wxPen(bg));
+            mdc.SetBrush(wxBrush(bg));
+            mdc.DrawRectangle(left, 0, right - left, gp.height);
+        }
+        else
+            mdc.DrawBitmap(s_layers.bmp[layer - 1], 0, 0);
+        SetGraphFont(mdc);
+        dl.Draw(mdc);
+        m_profile.Mark("draw");
+
+        mdc.DestroyClippingRegion();
+        mdc.SelectObject(wxNullBitmap);
+        s_layers.key[layer] = lkey;
+        s_layers.valid[layer] = true;
     }
 
+    dc.DrawBitmap(s_layers.bmp[NUM_LAYERS - 1], 0, 0);
+    m_profile.Mark("blit");
+
+    // the transient overlay is not cached
+    SetStrip(&gp, ginfo, entries.size(), 0, gp.width);
+    SetGraphFont(dc);
+    PaintGraphOverlay(dc, gp);
+
+    m_profile.End();
+    if (m_profile.IsShown())
+        m_profile.Draw(dc);
+}
+
+// labels, drag selection and scatter plot, drawn on every paint
+void LogViewFrame::PaintGraphOverlay(wxDC& dc, const GraphPaint& gp)
+{
+    static DrawList s_overlay;
+    s_overlay.Clear();
+
+    PaintGraphLabels(s_overlay, gp);
+
     if (s_drag.m_dragging &&
         (s_drag.m_dragMode == DRAG_EXCLUDE || s_drag.m_dragMode == DRAG_INCLUDE) &&
         s_drag.m_anchorPoint.x != s_drag.m_endPoint.x)
     {
         wxRect rect(s_drag.m_anchorPoint, s_drag.m_endPoint);
-
-        wxGraphicsContext *gc = wxGraphicsContext::Create(dc);
-        if (gc)
-        {
-            if (s_drag.m_dragMode == DRAG_EXCLUDE)
-                gc->SetBrush(wxColour(192, 192, 192, 64));
-            else
-                gc->SetBrush(wxColour(255, 255, 92, 64));
-
-            gc->DrawRectangle(rect.x, 0, rect.width, m_graph->GetSize().GetHeight());
-            delete gc;
-        }
+        wxColour shade(s_drag.m_dragMode == DRAG_EXCLUDE ? wxColour(192, 192, 192, 64) : wxColour(255, 255, 92, 64));
+        s_overlay.Fill(rect.x, 0, rect.width, gp.height, shade);
     }
 
+    s_overlay.Draw(dc);
+    m_profile.Mark("overlay");
+
     // scatter plot
     if (m_scatter->IsChecked())
     {
-        int h = m_graph->GetSize().GetHeight() / 2 - 40;
+        int h = gp.height / 2 - 40;
         if (h < 140) h = 140;
 
         if (!s_scatter.valid)
         {
-            if (!s_scatter.bitmap || s_scatter.bitmap->GetSize().GetWidth() != h)
-            {
-                delete s_scatter.bitmap;
-                s_scatter.bitmap = new wxBitmap(h, h);
-            }
-            wxMemoryDC mdc(*s_scatter.bitmap);
+            if (!s_scatter.bitmap)
+                s_scatter.bitmap = new wxBitmap();
+            *s_scatter.bitmap = ScatterBitmap(*m_session, h, gp.vscale, gp.height, gp.radec);
+            s_scatter.valid = true;
+            m_profile.Mark("scatter build");
+        }
 
-            mdc.SetBrush(*wxBLACK_BRUSH);
-            mdc.SetPen(*wxGREY_PEN);
-            mdc.DrawRectangle(0, 0, h, h);
-            mdc.DrawLine(h / 2, 0, h / 2, h);
-            mdc.DrawLine(0, h / 2, h, h / 2);
+        dc.DrawBitmap(*s_scatter.bitmap, gp.width - h, 0);
+        m_profile.Mark("scatter");
+    }
+}
 
-            mdc.SetPen(*wxYELLOW_PEN);
+// render a plot to path, as an SVG file or a PNG image
+static bool WritePlot(const wxString& path, const wxSize& size, bool svg, const std::function<void(wxDC&)>& paint)
+{
+    // wxSVGFileDC cannot Clear(), so the background is a rectangle
+    if (svg)
+    {
+        wxSVGFileDC dc(path, size.x, size.y);
+        dc.SetPen(*wxBLACK_PEN);
+        dc.SetBrush(*wxBLACK_BRUSH);
+        dc.DrawRectangle(0, 0, size.x, size.y);
+        paint(dc);
+        return dc.IsOk();
+    }
 
-            double scale = vscale * h * 0.5 / (double)(m_graph->GetSize().GetHeight() / 2 - 10);
+    wxBitmap bmp(size.x, size.y);
+    {
+        wxMemoryDC dc(bmp);
+        dc.SetPen(*wxBLACK_PEN);
+        dc.SetBrush(*wxBLACK_BRUSH);
+        dc.DrawRectangle(0, 0, size.x, size.y);
+        paint(dc);
+    }
+    return bmp.ConvertToImage().SaveFile(path, wxBITMAP_TYPE_PNG);
+}
+
+// Best of several builds of the draw list of a guide graph, of its
+// rasterization into an image and of the scatter plot bitmap, so the
+// rendering can be timed without a display. Returns a line of the
+// timing report.
+static wxString TimeGuideGraph(const GraphPaint& gp, const wxSize& size, int row)
+{
+    enum { RUNS = 10 };
 
-            for (auto it = entries.begin(); it != entries.end(); ++it)
+    DrawList dl;
+    wxImage img(size.x, size.y, false);
+    wxStopWatch sw;
+    double build = 0., raster = 0., scatter = 0.;
+
+    for (int i = 0; i < RUNS; i++)
+    {
+        sw.Start();
+        dl.Clear();
+        PaintGraphBackground(dl, gp);
+        PaintGraphData(dl, gp);
+        PaintGraphAnnotations(dl, gp);
+        PaintGraphLabels(dl, gp);
+        double t1 = sw.TimeInMicro().ToDouble() / 1000.;
+        img.Clear();
+        dl.Draw(img);
+        double t2 = sw.TimeInMicro().ToDouble() / 1000.;
+
+        if (i == 0 || t1 < build)
+            build = t1;
+        if (i == 0 || t2 - t1 < raster)
+            raster = t2 - t1;
+
+        // the size the window uses at this height
+        ScatterBitmap(*gp.session, std::max(size.y / 2 - 40, 140), gp.vscale, size.y, gp.radec);
+        double t3 = sw.TimeInMicro().ToDouble() / 1000.;
+        if (i == 0 || t3 - t2 < scatter)
+            scatter = t3 - t2;
+    }
+
+    return wxString::Format("%d\t%u\t%u\t%.3f\t%.3f\t%.3f\n", row, (unsigned int) gp.session->entries.size(),
+                            (unsigned int) dl.PointCount(), build, raster, scatter);
+}
+
+// Best of several rebuilds of the scatter plot of a synthetic session of
+// a million frames, at the size the window uses at this height. The
+// rebuild should stay under 10 ms.
+static wxString TimeSyntheticScatter(const wxSize& size)
+{
+    enum { FRAMES = 1000000, RUNS = 10 };
+
+    GuideSession session("synthetic");
+    session.entries.resize(FRAMES);
+    unsigned int seed = 1;
+    for (size_t i = 0; i < session.entries.size(); i++)
+    {
+        // roughly gaussian errors of about a pixel
+        float v[2];
+        for (int k = 0; k < 2; k++)
+        {
+            int sum = 0;
+            for (int j = 0; j < 4; j++)
             {
-                if (it->included)
-                {
-                    int x = (int)((double)(radec ? it->raraw : it->dx) * scale);
-                    int y = (int)((double)(radec ? it->decraw : it->dy) * scale);
-                    mdc.DrawPoint(h / 2 + x, h / 2 - y);
-                }
+                seed = seed * 1103515245 + 12345;
+                sum += (int)(seed >> 16 & 0x7fff);
             }
+            v[k] = (float)(sum - 2 * 0x8000) / 16384.f;
+        }
+        GuideEntry& e = session.entries[i];
+        e.frame = (int) i + 1;
+        e.dt = 2.f * (float) i;
+        e.mount = MOUNT;
+        e.included = true;
+        e.guiding = true;
+        e.dx = e.raraw = v[0];
+        e.dy = e.decraw = v[1];
+    }
+    session.theta = 0.;
+    session.lx = 1.;
+    session.ly = 1.;
 
-            // draw an ellipse showing the elongation
-            {
-                double const expand = 3.0;
-                double ew = m_session->lx * scale * expand;
-                double ehw = ew * 0.5;
-                double eh = m_session->ly * scale * expand;
-                double ehh = eh * 0.5;
+    // +/- 3 pixels fill the plot
+    double const vscale = (double)(size.y / 2 - 10) / 3.;
+    int const side = std::max(size.y / 2 - 40, 140);
 
-                wxGraphicsContext *gc = wxGraphicsContext::Create(mdc);
+    wxStopWatch sw;
+    double best = 0.;
+    for (int i = 0; i < RUNS; i++)
+    {
+        sw.Start();
+        ScatterBitmap(session, side, vscale, size.y, true);
+        double t = sw.TimeInMicro().ToDouble() / 1000.;
+        if (i == 0 || t < best)
+            best = t;
+    }
 
-                gc->Translate(h / 2 + m_session->avg_ra * scale, h / 2 - m_session->avg_dec * scale);
-                gc->Rotate(-m_session->theta);
+    return wxString::Format("%u\t%d\t%.3f\n", (unsigned int) FRAMES, side, best);
+}
 
-                gc->SetPen(wxPen(wxColour(255, 32, 255), 1));
-                gc->DrawEllipse(-ehw, -ehh, ew, eh);
-                gc->StrokeLine(-ehw * 1.5, 0.0, ehw * 1.5, 0.0);
-                gc->StrokeLine(0.0, -ehh * 1.5, 0.0, ehh * 1.5);
+// what the exported guide graphs show, the defaults of the graph controls
+static const unsigned int EXPORT_OPTS = GOPT_GRID | GOPT_RA | GOPT_DEC | GOPT_ARCSECS | GOPT_CORRECTIONS | GOPT_RADEC | GOPT_EVENTS;
 
-                delete gc;
-            }
+bool ExportLog(const wxString& filename, const wxString& outdir, const wxSize& size, bool svg, bool timing)
+{
+    std::ifstream ifs(filename.fn_str());
+    if (!ifs.good())
+    {
+        wxLogError("Cannot open file '%s'.", filename);
+        return false;
+    }
 
-            s_scatter.valid = true;
+    // the caches are keyed by session address, which the new log may reuse
+    s_lod.Clear();
+    s_eventLabels.Invalidate();
+
+    LogParser().Parse(ifs, s_log);
+    PrepareSessions();
+
+    // the summaries and analyses of the sessions are independent, so
+    // compute them in parallel; only the drawing is left to this thread
+    size_t const nsessions = s_log.sessions.size();
+    std::vector<MinMaxPyramid> lods(nsessions);
+    std::vector<std::unique_ptr<GARun> > runs(nsessions);
+    SpectrumOptions opts;
+    opts.mode = SPECTRUM_FFT;
+    opts.segment = s_settings.welch.segment;
+    opts.overlap = s_settings.welch.overlap;
+    ParallelFor(nsessions, [&](size_t i) {
+        const GuideSession& session = s_log.sessions[i];
+        std::atomic<bool> nocancel(false);
+        lods[i].Build(session.entries, nocancel);
+        if (AnalysisWin::CanAnalyzeAll(session))
+        {
+            runs[i].reset(new GARun());
+            runs[i]->Load(session, 0, session.entries.size(), false);
+            runs[i]->Process(opts);
+        }
+    });
+
+    wxString const ext = svg ? "svg" : "png";
+    wxFileName base(outdir, wxFileName(filename).GetName());
+    bool ok = true;
+    wxString report("row\tframes\tvertices\tbuild_ms\traster_ms\tscatter_ms\n");
+    wxString fftReport("frames\tfft_len\texact_ms\tfast_ms\tpeak_ratio\tmax_diff\n");
+
+    int row = 0;
+    for (auto it = s_log.sections.begin(); it != s_log.sections.end(); ++it)
+    {
+        ++row;
+        wxString const prefix = wxString::Format("%s-%d-", base.GetFullPath(), row);
+
+        if (it->type == CALIBRATION_SECTION)
+        {
+            Calibration *cal = &s_log.calibrations[it->idx];
+            InitCalDisplay(cal, size);
+            ok &= WritePlot(prefix + "calibration." + ext, size, svg, [&](wxDC& dc) {
+                PaintCalibration(dc, cal, size);
+            });
+            continue;
+        }
+
+        GuideSession *session = &s_log.sessions[it->idx];
+        size_t const n = session->entries.size();
+        InitGraph(session);
+
+        // the whole session fitted to the width
+        GraphInfo ginfo = session->m_ginfo;
+        ginfo.hscale = std::min((double) size.x / (double) std::max(n, (size_t) 1), MAX_HSCALE_GUIDE);
+        ginfo.width = size.x;
+        ginfo.xofs = 0;
+        ginfo.yofs = 0;
+        UpdateRange(&ginfo);
+
+        PaintProfile profile;
+        GraphPaint gp;
+        gp.session = session;
+        gp.ginfo = &ginfo;
+        gp.profile = &profile;
+        gp.width = size.x;
+        gp.height = size.y;
+        gp.y00 = gp.y0 = size.y / 2;
+        if (vscale_locked())
+            gp.vscale = get_vscale_setting(session->pixelScale);
+        else
+            gp.vscale = ginfo.max_ofs > 0.0 ? (double)(size.y / 2 - 10) / ginfo.max_ofs : 1.0;
+        gp.radec = true;
+        gp.lod = ginfo.hscale < LOD_HSCALE ? &lods[it->idx] : nullptr;
+        gp.opts = EXPORT_OPTS | (session->mount.isValid || !session->ao.isValid ? GOPT_MOUNT : 0);
+        SetStrip(&gp, ginfo, n, 0, size.x);
+
+        DrawList dl;
+        PaintGraphBackground(dl, gp);
+        PaintGraphData(dl, gp);
+        PaintGraphAnnotations(dl, gp);
+        PaintGraphLabels(dl, gp);
+
+        ok &= WritePlot(prefix + "guide." + ext, size, svg, [&](wxDC& dc) {
+            SetGraphFont(dc);
+            dl.Draw(dc);
+        });
+
+        if (timing)
+            report << TimeGuideGraph(gp, size, row);
+
+        int const side = size.y;
+        ok &= WritePlot(prefix + "scatter." + ext, wxSize(side, side), svg, [&](wxDC& dc) {
+            dc.DrawBitmap(ScatterBitmap(*session, side, gp.vscale, size.y, gp.radec), 0, 0);
+        });
+
+        const GARun *run = runs[it->idx].get();
+        if (run)
+        {
+            if (timing)
+                fftReport << TimeFFTLength(run->t, run->rac, run->len);
+            ok &= WritePlot(prefix + "drift." + ext, size, svg, [&](wxDC& dc) {
+                PaintAnalysisPlot(dc, size, *run, false, true);
+            });
+            ok &= WritePlot(prefix + "fft." + ext, size, svg, [&](wxDC& dc) {
+                PaintAnalysisPlot(dc, size, *run, true, true);
+            });
         }
+    }
 
-        dc.DrawBitmap(*s_scatter.bitmap, m_graph->GetSize().GetWidth() - h, 0);
+    bool checked = true;
+    if (timing)
+    {
+        std::ofstream ofs((base.GetFullPath() + "-timing.txt").fn_str());
+        // the FFT at the exact length the spectrum used to have against
+        // the fast length, for the sessions and for some prime lengths;
+        // a wrong length or a slow fast length fails the export
+        checked &= CheckFFTLengths(100000);
+        checked &= TimeFFTPrimes(&fftReport);
+        wxString scatterReport("synthetic_frames\tside\tscatter_ms\n");
+        scatterReport << TimeSyntheticScatter(size);
+        ofs << report.c_str() << "\n" << scatterReport.c_str() << "\n" << fftReport.c_str();
+        ok &= ofs.good();
     }
+
+    if (!ok)
+        wxLogError("Could not write all the graphs of '%s' to '%s'.", filename, outdir);
+
+    return ok && checked;
 }
 
 void LogViewFrame::OnVPlus( wxCommandEvent& event )
@@ -2098,7 +3438,7 @@ void LogViewFrame::OnHReset(wxCommandEvent& event)
     }
     else if (m_calibration)
     {
-        InitCalDisplay();
+        InitCalDisplay(m_calibration, m_graph->GetSize());
         m_graph->Refresh();
     }
 }
@@ -2199,6 +3539,24 @@ void LogViewFrame::OnKeyDown(wxKeyEvent& event)
             OnVPan(dummy);
             break;
         }
+        event.Skip();
+        break;
+    case WXK_F3:
+        // paint timing, for diagnosing slow redraws
+        if (event.ShiftDown())
+        {
+            if (wxClipboard::Get()->Open())
+            {
+                wxClipboard::Get()->SetData(new wxTextDataObject(m_profile.Report()));
+                wxClipboard::Get()->Close();
+            }
+        }
+        else
+        {
+            m_profile.Toggle();
+            m_graph->Refresh();
+        }
+        break;
     default:
         event.Skip();
         break;
@@ -21,10 +21,12 @@
 #define __LogViewFrame__
 
 #include "LogViewFrameBase.h"
+#include "paintprofile.h"
 
 #include <wx/timer.h>
 
 class AnalysisWin;
+struct GraphPaint;
 struct GuideSession;
 struct Calibration;
 
@@ -42,6 +44,9 @@ class LogViewFrame : public LogViewFrameBase
     GuideSession *m_session;
     Calibration *m_calibration;
     wxTimer m_timer;
+    wxTimer m_frameTimer;
+    wxLongLong_t m_lastPaint;
+    PaintProfile m_profile;
 
 public:
     AnalysisWin *m_analysisWin;
@@ -52,6 +57,9 @@ public:
     void OpenLog(const wxString& filename);
     bool ArcsecsSelected() const;
 
+    // called on the UI thread when a session's graph summary has been built
+    void OnLodReady();
+
 private:
     void OnFileOpen(wxCommandEvent& event);
     void OnFileSettings(wxCommandEvent& event);
@@ -61,6 +69,7 @@ private:
     void OnMenuInclude(wxCommandEvent& event);
     void OnMenuAnalyzeGA(wxCommandEvent& event);
     void OnMenuAnalyzeAll(wxCommandEvent& event);
+    void OnMenuScatterDensity(wxCommandEvent& event);
     // Handlers for LogViewFrameBase events.
     void OnCellSelected(wxGridEvent& event) override;
     void OnLeftDown(wxMouseEvent& event) override;
@@ -85,6 +94,8 @@ private:
     void OnDecChecked(wxCommandEvent& event) override;
     void OnRAChecked(wxCommandEvent& event) override;
     void OnTimer(wxTimerEvent& evt);
+    void OnFrameTimer(wxTimerEvent& evt);
+    void RequestPaint();
     void OnCaptureLost(wxMouseCaptureLostEvent& evt);
     void OnSizeGraph(wxSizeEvent& event) override;
     void OnIconize(wxIconizeEvent& event) override;
@@ -94,9 +105,12 @@ private:
     void OnStatsChar(wxKeyEvent& event) override;
     void OnLaunchEditor(wxCommandEvent& event) override;
 
-    void InitGraph();
-    void InitCalDisplay();
+    void PaintGraphOverlay(wxDC& dc, const GraphPaint& gp);
+
     void UpdateScrollbar();
+    // show the guide graph controls, or hide and disable them so their
+    // shortcuts do nothing
+    void ShowGuideControls(bool show);
 
     wxDECLARE_EVENT_TABLE();
 };
@@ -144,15 +158,39 @@ struct SettleParams
     double seconds;
 };
 
+struct OutlierParams
+{
+    double sigma;       // clip at sigma robust standard deviations
+    int iterations;
+};
+
+struct WelchParams
+{
+    double segment;     // segment length, seconds
+    double overlap;     // fraction of a segment shared with the next one
+};
+
 struct Settings
 {
     bool excludeByServer;
     bool excludeParametric;
     SettleParams settle;
+    bool excludeOutliers;
+    OutlierParams outliers;
+    WelchParams welch;
     wxColor raColor;
     wxColor decColor;
     double vscale;
+    bool scatterDensity;    // color the scatter plot by point density
 };
 extern Settings s_settings;
 
+// read s_settings from the config
+void LoadSettings();
+
+// Write the graphs of every section of a log to image files in outdir,
+// named after the log, without showing any window; PNG unless svg.
+// Returns false if the log could not be read or a file not written.
+bool ExportLog(const wxString& filename, const wxString& outdir, const wxSize& size, bool svg, bool timing);
+
 #endif // __LogViewFrame__
@@ -0,0 +1,343 @@
+/*
+ * This file is part of phdlogview
+ *
+ * Copyright (C) 2026 Andy Galasso
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, visit the http://fsf.org website.
+ */
+
+#include "drawlist.h"
+
+#include <wx/dcmemory.h>
+#include <wx/graphics.h>
+
+#include <algorithm>
+#include <stdlib.h>
+
+DrawList::DrawList()
+    :
+    m_ntext(0)
+{
+}
+
+void DrawList::Clear()
+{
+    m_cmds.clear();
+    m_pts.clear();
+    m_counts.clear();
+    m_ntext = 0;
+}
+
+DrawList::Cmd& DrawList::Add(Op op)
+{
+    m_cmds.push_back(Cmd());
+    Cmd& c = m_cmds.back();
+    c.op = op;
+    c.r = c.g = c.b = c.a = 0;
+    c.width = 1;
+    c.dot = false;
+    c.first = c.count = 0;
+    c.x = c.y = c.w = c.h = 0;
+    return c;
+}
+
+void DrawList::SetColour(Cmd& c, const wxColour& color)
+{
+    c.r = color.Red();
+    c.g = color.Green();
+    c.b = color.Blue();
+    c.a = color.Alpha();
+}
+
+void DrawList::SetPen(const wxColour& color, int width, wxPenStyle style)
+{
+    Cmd& c = Add(OP_PEN);
+    SetColour(c, color);
+    c.width = (unsigned char) std::max(std::min(width, 255), 1);
+    c.dot = style == wxPENSTYLE_DOT;
+}
+
+void DrawList::SetTextColour(const wxColour& color)
+{
+    SetColour(Add(OP_TEXT_COLOUR), color);
+}
+
+void DrawList::Line(int x0, int y0, int x1, int y1)
+{
+    wxPoint pts[2] = { wxPoint(x0, y0), wxPoint(x1, y1) };
+    Lines(2, pts);
+}
+
+void DrawList::Lines(size_t n, const wxPoint *pts)
+{
+    if (n < 2)
+        return;
+    Cmd& c = Add(OP_LINES);
+    c.first = (unsigned int) m_pts.size();
+    c.count = (unsigned int) n;
+    m_pts.insert(m_pts.end(), pts, pts + n);
+}
+
+void DrawList::Polygons(size_t n, const int *counts, const wxPoint *pts)
+{
+    if (n == 0)
+        return;
+    Cmd& c = Add(OP_POLYGONS);
+    c.first = (unsigned int) m_pts.size();
+    c.count = (unsigned int) n;
+    c.x = (int) m_counts.size();
+    size_t npts = 0;
+    for (size_t i = 0; i < n; i++)
+        npts += counts[i];
+    m_counts.insert(m_counts.end(), counts, counts + n);
+    m_pts.insert(m_pts.end(), pts, pts + npts);
+}
+
+void DrawList::Fill(int x, int y, int width, int height, const wxColour& color)
+{
+    if (width <= 0 || height <= 0)
+        return;
+    Cmd& c = Add(OP_FILL);
+    SetColour(c, color);
+    c.x = x;
+    c.y = y;
+    c.w = width;
+    c.h = height;
+}
+
+void DrawList::Text(const wxString& text, int x, int y)
+{
+    Cmd& c = Add(OP_TEXT);
+    if (m_ntext == m_text.size())
+        m_text.push_back(text);
+    else
+        m_text[m_ntext] = text;
+    c.first = (unsigned int) m_ntext++;
+    c.x = x;
+    c.y = y;
+}
+
+// Graphics context for the translucent fills, if dc is a kind that
+// wxGraphicsContext can draw on; null for others such as an SVG file.
+static wxGraphicsContext *CreateGC(wxDC& dc)
+{
+    wxMemoryDC *mdc = wxDynamicCast(&dc, wxMemoryDC);
+    if (mdc)
+        return wxGraphicsContext::Create(*mdc);
+    wxWindowDC *wdc = wxDynamicCast(&dc, wxWindowDC);
+    if (wdc)
+        return wxGraphicsContext::Create(*wdc);
+    return nullptr;
+}
+
+void DrawList::Draw(wxDC& dc) const
+{
+    // a run of fills shares one graphics context, which is deleted before
+    // anything else is drawn so the dc and the context do not interleave
+    wxGraphicsContext *gc = nullptr;
+    bool nogc = false;
+
+    for (size_t k = 0; k < m_cmds.size(); k++)
+    {
+        const Cmd& c = m_cmds[k];
+
+        if (c.op != OP_FILL && gc)
+        {
+            delete gc;
+            gc = nullptr;
+            nogc = false;
+        }
+
+        switch (c.op) {
+        case OP_PEN:
+            dc.SetPen(wxPen(Colour(c), c.width, c.dot ? wxPENSTYLE_DOT : wxPENSTYLE_SOLID));
+            break;
+        case OP_TEXT_COLOUR:
+            dc.SetTextForeground(Colour(c));
+            break;
+        case OP_LINES:
+            dc.DrawLines((int) c.count, &m_pts[c.first]);
+            break;
+        case OP_POLYGONS:
+            dc.SetBrush(*wxTRANSPARENT_BRUSH);
+            dc.DrawPolyPolygon((int) c.count, &m_counts[c.x], &m_pts[c.first]);
+            break;
+        case OP_FILL:
+            if (!gc && !nogc)
+            {
+                gc = CreateGC(dc);
+                nogc = !gc;
+                wxCoord x, y, w, h;
+                dc.GetClippingBox(&x, &y, &w, &h);
+                if (gc && w > 0 && h > 0)
+                    gc->Clip(x, y, w, h);
+            }
+            if (gc)
+            {
+                gc->SetPen(*wxTRANSPARENT_PEN);
+                gc->SetBrush(Colour(c));
+                gc->DrawRectangle(c.x, c.y, c.w, c.h);
+            }
+            else
+            {
+                // the SVG file dc honours the brush alpha
+                wxPen pen(dc.GetPen());
+                dc.SetPen(*wxTRANSPARENT_PEN);
+                dc.SetBrush(wxBrush(Colour(c)));
+                dc.DrawRectangle(c.x, c.y, c.w, c.h);
+                dc.SetPen(pen);
+            }
+            break;
+        case OP_TEXT:
+            dc.DrawText(m_text[c.first], c.x, c.y);
+            break;
+        }
+    }
+
+    delete gc;
+}
+
+namespace
+{
+    // pixel writer for the image backend, clipped to the image
+    struct Raster
+    {
+        unsigned char *data;
+        int w, h;
+        unsigned char r, g, b;
+        int width;
+        bool dot;
+        unsigned int step;
+
+        explicit Raster(wxImage& img)
+            : data(img.GetData()), w(img.GetWidth()), h(img.GetHeight()),
+            r(0), g(0), b(0), width(1), dot(false), step(0) { }
+
+        void Plot(int x, int y)
+        {
+            // a dotted pen draws every other pixel along the line
+            if (dot && (step++ & 1))
+                return;
+            for (int yy = y; yy < y + width; yy++)
+            {
+                if (yy < 0 || yy >= h)
+                    continue;
+                for (int xx = x; xx < x + width; xx++)
+                {
+                    if (xx < 0 || xx >= w)
+                        continue;
+                    unsigned char *p = data + 3 * ((size_t) yy * w + xx);
+                    p[0] = r;
+                    p[1] = g;
+                    p[2] = b;
+                }
+            }
+        }
+
+        // Bresenham, without the end point, like wxDC::DrawLine
+        void Line(int x0, int y0, int x1, int y1)
+        {
+            int dx = abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
+            int dy = -abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
+            int err = dx + dy;
+            while (x0 != x1 || y0 != y1)
+            {
+                Plot(x0, y0);
+                int e2 = 2 * err;
+                if (e2 >= dy)
+                {
+                    err += dy;
+                    x0 += sx;
+                }
+                if (e2 <= dx)
+                {
+                    err += dx;
+                    y0 += sy;
+                }
+            }
+        }
+
+        void Blend(int x, int y, int rw, int rh, const wxColour& color)
+        {
+            int x0 = std::max(x, 0), x1 = std::min(x + rw, w);
+            int y0 = std::max(y, 0), y1 = std::min(y + rh, h);
+            unsigned int a = color.Alpha();
+            unsigned int src[3] = { color.Red() * a, color.Green() * a, color.Blue() * a };
+            for (int yy = y0; yy < y1; yy++)
+            {
+                unsigned char *p = data + 3 * ((size_t) yy * w + x0);
+                for (int xx = x0; xx < x1; xx++, p += 3)
+                    for (int i = 0; i < 3; i++)
+                        p[i] = (unsigned char)((src[i] + p[i] * (255 - a)) / 255);
+            }
+        }
+    };
+}
+
+void DrawList::Draw(wxImage& img) const
+{
+    if (!img.IsOk())
+        return;
+
+    Raster ras(img);
+
+    for (size_t k = 0; k < m_cmds.size(); k++)
+    {
+        const Cmd& c = m_cmds[k];
+
+        switch (c.op) {
+        case OP_PEN:
+            ras.r = c.r;
+            ras.g = c.g;
+            ras.b = c.b;
+            ras.width = c.width;
+            ras.dot = c.dot;
+            break;
+        case OP_LINES:
+        {
+            ras.step = 0;
+            const wxPoint *p = &m_pts[c.first];
+            for (unsigned int i = 1; i < c.count; i++)
+                ras.Line(p[i - 1].x, p[i - 1].y, p[i].x, p[i].y);
+            break;
+        }
+        case OP_POLYGONS:
+        {
+            const wxPoint *p = &m_pts[c.first];
+            for (unsigned int i = 0; i < c.count; i++)
+            {
+                int n = m_counts[c.x + i];
+                ras.step = 0;
+                for (int j = 0; j < n; j++)
+                {
+                    const wxPoint& a = p[j];
+                    const wxPoint& b = p[(j + 1) % n];
+                    ras.Line(a.x, a.y, b.x, b.y);
+                }
+                // a degenerate polygon is still a pixel
+                if (n == 1 || (n == 2 && p[0] == p[1]))
+                    ras.Plot(p[0].x, p[0].y);
+                p += n;
+            }
+            break;
+        }
+        case OP_FILL:
+            ras.Blend(c.x, c.y, c.w, c.h, Colour(c));
+            break;
+        case OP_TEXT_COLOUR:
+        case OP_TEXT:
+            break;
+        }
+    }
+}
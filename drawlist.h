@@ -0,0 +1,104 @@
+/*
+ * This file is part of phdlogview
+ *
+ * Copyright (C) 2026 Andy Galasso
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, visit the http://fsf.org website.
+ */
+
+#ifndef DRAWLIST_INCLUDED
+#define DRAWLIST_INCLUDED
+
+#include <wx/colour.h>
+#include <wx/dc.h>
+#include <wx/gdicmn.h>
+#include <wx/image.h>
+#include <wx/string.h>
+
+#include <vector>
+
+// A recorded sequence of drawing commands in screen coordinates:
+// polylines, polygon outlines, translucent rectangles and text runs.
+//
+// The graph painters fill a list instead of drawing, and a backend then
+// executes it on a wxDC or straight into the pixels of a wxImage, which
+// needs no display. Clear() keeps the storage, so a list that is rebuilt
+// on every paint does not allocate once it has grown.
+class DrawList
+{
+public:
+    DrawList();
+
+    void Clear();
+    bool IsEmpty() const { return m_cmds.empty(); }
+    // vertices recorded, for profiling
+    size_t PointCount() const { return m_pts.size(); }
+
+    // pen for the lines and outlines that follow; style is wxPENSTYLE_SOLID
+    // or wxPENSTYLE_DOT
+    void SetPen(const wxColour& color, int width = 1, wxPenStyle style = wxPENSTYLE_SOLID);
+    // color of the text runs that follow; until set, the backend's default
+    void SetTextColour(const wxColour& color);
+
+    void Line(int x0, int y0, int x1, int y1);
+    void Lines(size_t n, const wxPoint *pts);
+    // outlines of n closed polygons, counts[i] vertices each
+    void Polygons(size_t n, const int *counts, const wxPoint *pts);
+    // fill a rectangle with color, blended by its alpha
+    void Fill(int x, int y, int width, int height, const wxColour& color);
+    void Text(const wxString& text, int x, int y);
+
+    // Draw on dc with its current font and text color. The translucent
+    // fills go through a graphics context when dc supports one, clipped
+    // like dc; other kinds of dc get a brush with alpha.
+    void Draw(wxDC& dc) const;
+    // Rasterize into img without a display. Lines are not anti-aliased
+    // and the text runs are skipped since there is no font renderer.
+    void Draw(wxImage& img) const;
+
+private:
+    enum Op
+    {
+        OP_PEN,
+        OP_TEXT_COLOUR,
+        OP_LINES,
+        OP_POLYGONS,
+        OP_FILL,
+        OP_TEXT,
+    };
+
+    struct Cmd
+    {
+        unsigned char op;
+        unsigned char r, g, b, a;
+        unsigned char width;    // OP_PEN
+        bool dot;               // OP_PEN
+        unsigned int first;     // index into the points or the text
+        unsigned int count;     // points or polygons
+        int x, y, w, h;         // OP_FILL rectangle, OP_TEXT position,
+                                // OP_POLYGONS index into the counts in x
+    };
+
+    std::vector<Cmd> m_cmds;
+    std::vector<wxPoint> m_pts;
+    std::vector<int> m_counts;
+    std::vector<wxString> m_text;
+    size_t m_ntext;             // used entries of m_text, which are kept for reuse
+
+    Cmd& Add(Op op);
+    static void SetColour(Cmd& c, const wxColour& color);
+    static wxColour Colour(const Cmd& c) { return wxColour(c.r, c.g, c.b, c.a); }
+};
+
+#endif
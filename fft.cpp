@@ -0,0 +1,139 @@
+/*
+ * This file is part of phdlogview
+ *
+ * Copyright (C) 2026 Andy Galasso
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, visit the http://fsf.org website.
+ */
+
+#include "fft.h"
+
+#include <gsl/gsl_fft_real.h>
+#include <algorithm>
+#include <math.h>
+#include <mutex>
+#include <vector>
+
+struct FFTPlan
+{
+    size_t n;
+    gsl_fft_real_wavetable *wt;
+    gsl_fft_real_workspace *work;
+
+    FFTPlan(size_t n_) : n(n_), wt(gsl_fft_real_wavetable_alloc(n_)), work(gsl_fft_real_workspace_alloc(n_)) { }
+    ~FFTPlan()
+    {
+        gsl_fft_real_workspace_free(work);
+        gsl_fft_real_wavetable_free(wt);
+    }
+};
+
+// idle plans, most recently used last
+struct PlanCache
+{
+    enum { MAX_PLANS = 16 };
+
+    std::mutex lock;
+    std::vector<FFTPlan *> plans;
+
+    FFTPlan *Get(size_t n)
+    {
+        {
+            std::lock_guard<std::mutex> lck(lock);
+            for (size_t i = plans.size(); i > 0; --i)
+            {
+                FFTPlan *p = plans[i - 1];
+                if (p->n == n)
+                {
+                    plans.erase(plans.begin() + (i - 1));
+                    return p;
+                }
+            }
+        }
+        return new FFTPlan(n);
+    }
+
+    void Put(FFTPlan *p)
+    {
+        FFTPlan *evict = 0;
+        {
+            std::lock_guard<std::mutex> lck(lock);
+            plans.push_back(p);
+            if (plans.size() > MAX_PLANS)
+            {
+                evict = plans.front();
+                plans.erase(plans.begin());
+            }
+        }
+        delete evict;
+    }
+
+    ~PlanCache()
+    {
+        for (auto it = plans.begin(); it != plans.end(); ++it)
+            delete *it;
+    }
+};
+
+static PlanCache s_plans;
+
+RealFFT::RealFFT(size_t n)
+    : m_n(n), m_plan(s_plans.Get(n))
+{
+}
+
+RealFFT::~RealFFT()
+{
+    s_plans.Put(static_cast<FFTPlan *>(m_plan));
+}
+
+void RealFFT::Forward(double *data) const
+{
+    FFTPlan *p = static_cast<FFTPlan *>(m_plan);
+    gsl_fft_real_transform(data, 1, m_n, p->wt, p->work);
+}
+
+RealFFTLanes::~RealFFTLanes()
+{
+    for (auto it = m_lanes.begin(); it != m_lanes.end(); ++it)
+        delete *it;
+}
+
+void RealFFTLanes::Reserve(size_t n, size_t lanes)
+{
+    if (n != m_n)
+    {
+        for (auto it = m_lanes.begin(); it != m_lanes.end(); ++it)
+            delete *it;
+        m_lanes.clear();
+        m_n = n;
+    }
+    while (m_lanes.size() < lanes)
+        m_lanes.push_back(new RealFFT(n));
+}
+
+void RealFFTLanes::Swap(RealFFTLanes& other)
+{
+    std::swap(m_n, other.m_n);
+    m_lanes.swap(other.m_lanes);
+}
+
+double RealFFT::Abs(const double *hc, size_t n, size_t k)
+{
+    if (k == 0)
+        return fabs(hc[0]);
+    if (2 * k == n)
+        return fabs(hc[n - 1]);
+    return hypot(hc[2 * k - 1], hc[2 * k]);
+}
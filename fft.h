@@ -0,0 +1,76 @@
+/*
+ * This file is part of phdlogview
+ *
+ * Copyright (C) 2026 Andy Galasso
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, visit the http://fsf.org website.
+ */
+
+#ifndef FFT_INCLUDED
+#define FFT_INCLUDED
+
+#include <stddef.h>
+#include <vector>
+
+// Forward FFT of real data.
+//
+// The GSL wavetable and workspace for a given length are taken from a
+// process-wide cache on construction and returned to it on destruction,
+// so repeated analyses of the same length do not reallocate them. Each
+// instance owns its plan, so instances can be used from different
+// threads at the same time.
+class RealFFT
+{
+    size_t m_n;
+    void *m_plan;
+
+    RealFFT(const RealFFT&);
+    RealFFT& operator=(const RealFFT&);
+
+public:
+    RealFFT(size_t n);
+    ~RealFFT();
+
+    size_t Size() const { return m_n; }
+
+    // in-place transform of data[0..n), the result is in GSL half-complex order
+    void Forward(double *data) const;
+
+    // magnitude of the k'th coefficient of a half-complex array, 0 <= k <= n/2
+    static double Abs(const double *hc, size_t n, size_t k);
+};
+
+// RealFFT instances of one length, one for each lane of a parallel loop.
+// They are kept between uses, so repeated transforms of the same length
+// in no more lanes do not allocate, even when the plan cache is full.
+class RealFFTLanes
+{
+    size_t m_n;
+    std::vector<RealFFT *> m_lanes;
+
+    RealFFTLanes(const RealFFTLanes&);
+    RealFFTLanes& operator=(const RealFFTLanes&);
+
+public:
+    RealFFTLanes() : m_n(0) { }
+    ~RealFFTLanes();
+
+    // make at least lanes instances of length n available; call before
+    // the parallel loop, it is not thread-safe
+    void Reserve(size_t n, size_t lanes);
+    const RealFFT& operator[](size_t lane) const { return *m_lanes[lane]; }
+    void Swap(RealFFTLanes& other);
+};
+
+#endif
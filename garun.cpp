@@ -0,0 +1,745 @@
+/*
+ * This file is part of phdlogview
+ *
+ * Copyright (C) 2018 Andy Galasso
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, visit the http://fsf.org website.
+ */
+
+#include "garun.h"
+
+#include "logparser.h"
+#include "spectrum.h"
+
+#include <algorithm>
+#include <atomic>
+#include <gsl/gsl_spline.h>
+#include <wx/log.h>
+#include <wx/stopwatch.h>
+
+void Spline::Init(const double *x, const double *y, size_t n)
+{
+    if (accel)
+        gsl_interp_accel_reset(static_cast<gsl_interp_accel *>(accel));
+    else
+        accel = gsl_interp_accel_alloc();
+
+    if (!spline || size != n)
+    {
+        if (spline)
+            gsl_spline_free(static_cast<gsl_spline *>(spline));
+        spline = gsl_spline_alloc(gsl_interp_akima, n);
+        size = n;
+    }
+
+    gsl_spline_init(static_cast<gsl_spline *>(spline), x, y, n);
+}
+
+Spline::~Spline()
+{
+    gsl_spline_free(static_cast<gsl_spline *>(spline));
+    gsl_interp_accel_free(static_cast<gsl_interp_accel *>(accel));
+}
+
+double Spline::Eval(double x) const
+{
+    return gsl_spline_eval(static_cast<gsl_spline *>(spline),
+        x, static_cast<gsl_interp_accel *>(accel));
+}
+
+void Spline::Swap(Spline& other)
+{
+    std::swap(spline, other.spline);
+    std::swap(accel, other.accel);
+    std::swap(size, other.size);
+}
+
+double Spline::EvalNoAccel(double x) const
+{
+    return gsl_spline_eval(static_cast<gsl_spline *>(spline), x, nullptr);
+}
+
+struct Line
+{
+    double a, b;
+    Line(const LFit& lf) {
+        lf.result(&a, &b);
+    }
+    double operator()(double x) { return a + b * x; }
+};
+
+// smallest length >= n whose only prime factors are 2, 3, 5 and 7
+static size_t FastFFTLength(size_t n)
+{
+    for (size_t m = n; ; m++)
+    {
+        size_t r = m;
+        static const size_t factors[] = { 2, 3, 5, 7 };
+        for (size_t i = 0; i < 4; i++)
+            while (r % factors[i] == 0)
+                r /= factors[i];
+        if (r == 1)
+            return m;
+    }
+}
+
+bool GARun::CanAnalyze(const GuideSession& session, size_t begin, size_t end)
+{
+    const auto& entries = session.entries;
+    const auto& p0 = entries.begin() + begin;
+    const auto& p1 = entries.begin() + end;
+
+    enum { MIN_ENTRIES = 12 }; // need at least 12 for FFT output spline (N / 2 - 1 >= 5)
+
+    size_t n = 0;
+    for (auto it = p0; it != p1; ++it)
+        if (Include(*it) && ++n >= MIN_ENTRIES)
+            return true;
+
+    return false;
+}
+
+void GARun::Load(const GuideSession& session, size_t begin, size_t end, bool undo_ra_corrections)
+{
+    starts = session.starts;
+    pixscale = session.pixelScale;
+
+    const auto& entries = session.entries;
+    const auto& p0 = entries.begin() + begin;
+    const auto& p1 = entries.begin() + end;
+
+    size_t n = std::count_if(p0, p1, &Include);
+
+    Alloc(n);
+
+    double *pt = &t[0];
+    double *pra = &ra[0];
+    double *pdec = &dec[0];
+
+    double rapos = 0.;
+    double prev_raguide = 0.;
+    double prev_raraw = 0.;
+
+    for (auto it = p0; it != p1; ++it)
+    {
+        const GuideEntry& e = *it;
+        if (Include(e))
+        {
+            double const raraw = e.raraw;
+            double const raguide = e.raguide;
+            double const move = raraw - prev_raraw - prev_raguide;
+            rapos += move;
+            prev_raraw = raraw;
+            prev_raguide = undo_ra_corrections ? raguide : 0.;
+
+            *pt++ = e.dt;
+            *pra++ = rapos;
+            *pdec++ = e.decraw;
+        }
+    }
+}
+
+void GARun::LoadFrom(const GARun& src)
+{
+    starts = src.starts;
+    pixscale = src.pixscale;
+
+    Alloc(src.len);
+
+    std::copy(src.t.Data(), src.t + len, t.Data());
+    std::copy(src.ra.Data(), src.ra + len, ra.Data());
+    std::copy(src.dec.Data(), src.dec + len, dec.Data());
+}
+
+void GARun::Alloc(size_t n)
+{
+    sgram.valid = false;
+    len = n;
+    t.Reserve(n);
+    ra.Reserve(n);
+    dec.Reserve(n);
+    rac.Reserve(n);
+    decc.Reserve(n);
+}
+
+void GARun::CopyFrom(const GARun& src)
+{
+    LoadFrom(src);
+
+    std::copy(src.rac.Data(), src.rac + len, rac.Data());
+    std::copy(src.decc.Data(), src.decc + len, decc.Data());
+
+    SetSpectrum(src.nfft);
+    std::copy(src.fftx.Data(), src.fftx + nfft, fftx.Data());
+    std::copy(src.ffty.Data(), src.ffty + nfft, ffty.Data());
+    std::copy(src.fftdy.Data(), src.fftdy + nfft, fftdy.Data());
+    FinishSpectrum();
+}
+
+size_t GARun::MemSize() const
+{
+    // the splines keep about 6 doubles per point
+    size_t n = t.Capacity() + ra.Capacity() + dec.Capacity() + rac.Capacity() + decc.Capacity() +
+        fftx.Capacity() + ffty.Capacity() + fftdy.Capacity() + fftbuf.Capacity() +
+        2 * 6 * nfft + 2 * 6 * len +
+        lsfreq.capacity() + lsra.capacity() + lsdec.capacity() +
+        (sgram.amp[0].Capacity() + sgram.amp[1].Capacity()) / 2;
+    return n * sizeof(double);
+}
+
+bool GARun::Process(const SpectrumOptions& opts, AnalysisMonitor *mon)
+{
+    sgram.valid = false;
+
+    // drift correction
+
+    LFit fitR; // ra fit
+    LFit fitD; // dec fit
+
+    for (size_t i = 0; i < len; i++)
+    {
+        fitR.data(t[i], ra[i]);
+        fitD.data(t[i], dec[i]);
+    }
+
+    Line lR(fitR);
+    Line lD(fitD);
+
+    for (size_t i = 0; i < len; i++)
+    {
+        rac[i] = ra[i] - lR(t[i]);
+        decc[i] = dec[i] - lD(t[i]);
+    }
+
+    if (mon)
+    {
+        if (mon->Cancelled())
+            return false;
+        mon->Progress(10);
+    }
+
+    return CalcSpectrum(opts, mon);
+}
+
+bool GARun::CalcSpectrum(const SpectrumOptions& opts, AnalysisMonitor *mon)
+{
+    switch (opts.mode)
+    {
+    case SPECTRUM_LOMB_SCARGLE:
+        if (!LombScargleSpectrum(mon))
+            return false;
+        break;
+    case SPECTRUM_WELCH:
+        if (!WelchSpectrum(opts.segment, opts.overlap, mon))
+            return false;
+        break;
+    default:
+        FFTSpectrum();
+        break;
+    }
+
+    if (mon)
+    {
+        if (mon->Cancelled())
+            return false;
+        mon->Progress(100);
+    }
+
+    return true;
+}
+
+void GARun::Swap(GARun& other)
+{
+    std::swap(starts, other.starts);
+    std::swap(pixscale, other.pixscale);
+    std::swap(len, other.len);
+    t.Swap(other.t);
+    ra.Swap(other.ra);
+    dec.Swap(other.dec);
+    rac.Swap(other.rac);
+    decc.Swap(other.decc);
+    std::swap(nfft, other.nfft);
+    fftx.Swap(other.fftx);
+    ffty.Swap(other.ffty);
+    fftdy.Swap(other.fftdy);
+    ffts.Swap(other.ffts);
+    fftds.Swap(other.fftds);
+    std::swap(fftymax, other.fftymax);
+    fftbuf.Swap(other.fftbuf);
+    rasp.Swap(other.rasp);
+    decsp.Swap(other.decsp);
+    fftplans.Swap(other.fftplans);
+    sgplans.Swap(other.sgplans);
+    lsfreq.swap(other.lsfreq);
+    lsra.swap(other.lsra);
+    lsdec.swap(other.lsdec);
+    sgram.Swap(other.sgram);
+}
+
+// allocate the spectrum arrays for n frequencies
+void GARun::SetSpectrum(size_t n)
+{
+    nfft = n;
+    fftx.Reserve(n);
+    ffty.Reserve(n);
+    fftdy.Reserve(n);
+    fftymax = 0.;
+}
+
+// fill in the amplitude maximum and the graphing splines once fftx, ffty
+// and fftdy are set
+void GARun::FinishSpectrum()
+{
+    for (size_t i = 0; i < nfft; i++)
+    {
+        if (ffty[i] > fftymax)
+            fftymax = ffty[i];
+        if (fftdy[i] > fftymax)
+            fftymax = fftdy[i];
+    }
+
+    ffts.Init(fftx, ffty, nfft);
+    fftds.Init(fftx, fftdy, nfft);
+}
+
+// Hamming-windowed FFT of y resampled to fft.Size() points; puts the
+// amplitudes of frequencies 1 .. nf into amp in ascending period order
+static void ResampledFFT(const double *t, const double *y, size_t n, Spline& spline, const RealFFT& fft, double *data, double *amp, size_t nf)
+{
+    size_t const m = fft.Size();
+    double dt = (t[n - 1] - t[0]) / (double) (m - 1);
+
+    {
+        double const k = M_PI * 2.0 / (double) (m - 1);
+        spline.Init(t, y, n);
+        double x = t[0];
+        for (unsigned int i = 0; i < m; i++, x += dt)
+        {
+            if (x > t[n - 1]) x = t[n - 1]; // rounding error can put the last point over the boundary
+            // Hamming window
+            double const hw = 0.54 - 0.46 * cos(i * k);
+            data[i] = hw * spline.Eval(x);
+        }
+    }
+
+    fft.Forward(data);
+
+    double scale = 4. / (double) m; // http://www.stat.ucla.edu/~frederic/221/W17/221ch4a.pdf
+
+    for (size_t i = 0; i < nf; i++)
+        amp[nf - 1 - i] = RealFFT::Abs(data, m, i + 1) * scale;
+}
+
+void GARun::FFTSpectrum()
+{
+    size_t const n = len;
+
+    // interpolate RA and Dec to get uniform samples for FFT
+    //
+    // The samples are already resampled from the spline, so rather than
+    // FFT'ing exactly n points (GSL's mixed-radix FFT degrades to O(n^2)
+    // for large prime factors of n) take m >= n samples where m only has
+    // factors GSL has fast radix routines for.
+
+    size_t const m = FastFFTLength(n);
+
+    fftbuf.Reserve(2 * m);
+
+    double dt = (t[n - 1] - t[0]) / (double) (m - 1);
+
+    SetSpectrum(m / 2 - 1); // omit steady state f=0
+
+    for (size_t i = 0; i < nfft; i++)
+    {
+        double f = (double) (i + 1) / ((double) m * dt);
+        fftx[nfft - 1 - i] = 1. / f;
+    }
+
+    // RA and Dec are independent, do them at the same time
+    fftplans.Reserve(m, 2);
+    ParallelFor(2, [this, n, m](size_t k) {
+        if (k == 0)
+            ResampledFFT(t, rac, n, rasp, fftplans[0], fftbuf, ffty, nfft);
+        else
+            ResampledFFT(t, decc, n, decsp, fftplans[1], fftbuf + m, fftdy, nfft);
+    });
+
+    FinishSpectrum();
+}
+
+// amplitudes and periods, in ascending period order, of the FFT of y
+// resampled to m points; returns the time taken, ms
+static double TimedFFT(const double *t, const double *y, size_t n, size_t m, std::vector<double>& amp, std::vector<double>& period)
+{
+    size_t const nf = m / 2 - 1;
+    std::vector<double> data(m);
+    amp.resize(nf);
+    period.resize(nf);
+    Spline spline;
+    RealFFT fft(m);
+
+    wxStopWatch sw;
+    ResampledFFT(t, y, n, spline, fft, &data[0], &amp[0], nf);
+    double ms = sw.TimeInMicro().ToDouble() / 1000.;
+
+    double const span = (t[n - 1] - t[0]) * (double) m / (double) (m - 1);
+    for (size_t i = 0; i < nf; i++)
+        period[nf - 1 - i] = span / (double) (i + 1);
+
+    return ms;
+}
+
+wxString TimeFFTLength(const double *t, const double *y, size_t n, bool *faster)
+{
+    enum { RUNS = 3 };
+
+    size_t const m = FastFFTLength(n);
+    std::vector<double> ampn, pern, ampm, perm;
+    double exact = 0., fast = 0.;
+    for (int i = 0; i < RUNS; i++)
+    {
+        double t1 = TimedFFT(t, y, n, n, ampn, pern);
+        double t2 = TimedFFT(t, y, n, m, ampm, perm);
+        if (i == 0 || t1 < exact)
+            exact = t1;
+        if (i == 0 || t2 < fast)
+            fast = t2;
+    }
+
+    // the fast spectrum at the periods of the exact one; the longest
+    // period of the exact spectrum can be just beyond the fast one's
+    Spline sp(&perm[0], &ampm[0], perm.size());
+    double maxn = *std::max_element(ampn.begin(), ampn.end());
+    double maxm = *std::max_element(ampm.begin(), ampm.end());
+    double diff = 0.;
+    for (size_t i = 0; i < pern.size(); i++)
+        if (pern[i] >= perm.front() && pern[i] <= perm.back())
+            diff = std::max(diff, fabs(sp.Eval(pern[i]) - ampn[i]));
+
+    if (faster)
+        *faster = fast < exact;
+
+    return wxString::Format("%u\t%u\t%.3f\t%.3f\t%.4f\t%.4f\n", (unsigned int) n, (unsigned int) m, exact, fast,
+                            maxn > 0. ? maxm / maxn : 1., maxn > 0. ? diff / maxn : 0.);
+}
+
+bool TimeFFTPrimes(wxString *report)
+{
+    static const size_t lengths[] = { 1009, 2003, 4001, 8009, 16001 };
+
+    bool ok = true;
+    for (size_t k = 0; k < sizeof(lengths) / sizeof(lengths[0]); k++)
+    {
+        size_t const n = lengths[k];
+        std::vector<double> t(n), y(n);
+        unsigned int seed = 1;
+        for (size_t i = 0; i < n; i++)
+        {
+            // 2s frames with some jitter, a 480s and a 120s periodic
+            // error and a little noise
+            seed = seed * 1103515245 + 12345;
+            double noise = (double) (seed >> 16 & 0x7fff) / 32768. - 0.5;
+            t[i] = 2. * (double) i + 0.3 * sin((double) i * 1.7);
+            y[i] = 1.5 * sin(2. * M_PI * t[i] / 480.) + 0.5 * sin(2. * M_PI * t[i] / 120.) + 0.2 * noise;
+        }
+        bool faster;
+        *report << TimeFFTLength(&t[0], &y[0], n, &faster);
+        if (!faster)
+        {
+            wxLogError("The FFT of %u frames at length %u is not faster than at the prime length.",
+                       (unsigned int) n, (unsigned int) FastFFTLength(n));
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+bool CheckFFTLengths(size_t nmax)
+{
+    // the 7-smooth numbers up to the length for nmax, generated as products
+    // of powers rather than by factoring as FastFFTLength does
+    size_t const lim = std::max(FastFFTLength(nmax), nmax);
+    std::vector<bool> smooth(lim + 1, false);
+    for (size_t a = 1; a <= lim; a *= 2)
+        for (size_t b = a; b <= lim; b *= 3)
+            for (size_t c = b; c <= lim; c *= 5)
+                for (size_t d = c; d <= lim; d *= 7)
+                    smooth[d] = true;
+
+    // walk down keeping the smallest 7-smooth number >= n, which is what
+    // FastFFTLength(n) must return
+    size_t next = 0;
+    for (size_t n = lim; n >= 1; n--)
+    {
+        if (smooth[n])
+            next = n;
+        if (n <= nmax && FastFFTLength(n) != next)
+        {
+            wxLogError("FastFFTLength(%u) is %u, expected %u.", (unsigned int) n,
+                       (unsigned int) FastFFTLength(n), (unsigned int) next);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Hamming-windowed FFT of fft.Size() samples of the spline taken every dt
+// from x0, with the mean removed
+static void SegmentFFT(const Spline& spline, double x0, double dt, double tmax, const RealFFT& fft, double *data)
+{
+    size_t const seg = fft.Size();
+
+    double mean = 0.;
+    for (size_t i = 0; i < seg; i++)
+    {
+        double const x = std::min(x0 + (double) i * dt, tmax);
+        data[i] = spline.EvalNoAccel(x);
+        mean += data[i];
+    }
+    mean /= (double) seg;
+
+    double const k = M_PI * 2.0 / (double) (seg - 1);
+    for (size_t i = 0; i < seg; i++)
+        data[i] = (0.54 - 0.46 * cos(i * k)) * (data[i] - mean);
+
+    fft.Forward(data);
+}
+
+// Welch's method: Hamming-windowed FFTs of overlapping segments of the
+// resampled series, with the power averaged over the segments. Each
+// segment is evaluated straight from the spline, so memory use is
+// proportional to the segment length times the number of workers, not
+// the length of the run.
+bool GARun::WelchSpectrum(double segment, double overlap, AnalysisMonitor *mon)
+{
+    size_t const n = len;
+
+    // same sample spacing as the single FFT
+    double const dt = (t[n - 1] - t[0]) / (double) (n - 1);
+
+    size_t const seg = FastFFTLength(std::max((size_t) 16, (size_t) (segment / dt + 0.5)));
+    if (seg >= FastFFTLength(n))
+    {
+        // only one segment fits, same as the plain FFT
+        FFTSpectrum();
+        return true;
+    }
+
+    size_t const hop = std::max((size_t) 1, (size_t) ((double) seg * (1. - overlap) + 0.5));
+    size_t const nseg = (n - seg) / hop + 1;
+    size_t const nf = seg / 2 - 1; // omit steady state f=0
+
+    rasp.Init(t, rac, n);
+    decsp.Init(t, decc, n);
+    const Spline *spline[2] = { &rasp, &decsp };
+    double const tmax = t[n - 1];
+
+    // each lane has its own segment buffer and RA and Dec power sums in
+    // fftbuf, so the segments need no locking and no allocation
+    size_t const ntasks = 2 * nseg;
+    size_t const nlanes = std::min((size_t) WorkerCount(), ntasks);
+    size_t const lanesz = seg + 2 * nf;
+    fftbuf.Reserve(nlanes * lanesz);
+    std::fill(fftbuf.Data(), fftbuf + nlanes * lanesz, 0.);
+    fftplans.Reserve(seg, nlanes);
+
+    std::atomic<size_t> next(0);
+    std::atomic<size_t> done(0);
+
+    ParallelFor(nlanes, [&](size_t lane) {
+        double *const data = fftbuf + lane * lanesz;
+        double *const power = data + seg;
+        const RealFFT& fft = fftplans[lane];
+
+        // RA segments are even tasks, Dec segments odd
+        size_t task;
+        while ((task = next++) < ntasks)
+        {
+            if (mon && mon->Cancelled())
+                return;
+
+            size_t const s = task / 2;
+            size_t const which = task % 2;
+
+            double const x0 = t[0] + (double) (s * hop) * dt;
+            SegmentFFT(*spline[which], x0, dt, tmax, fft, data);
+
+            double *const pw = power + which * nf;
+            for (size_t i = 0; i < nf; i++)
+            {
+                double a = RealFFT::Abs(data, seg, i + 1);
+                pw[i] += a * a;
+            }
+
+            if (mon)
+                mon->Progress((int) (10 + 90 * ++done / ntasks));
+        }
+    });
+
+    if (mon && mon->Cancelled())
+        return false;
+
+    // add the other lanes' sums into the first lane's
+    double *const power = fftbuf + seg;
+    for (size_t lane = 1; lane < nlanes; lane++)
+    {
+        const double *pw = fftbuf + lane * lanesz + seg;
+        for (size_t i = 0; i < 2 * nf; i++)
+            power[i] += pw[i];
+    }
+
+    SetSpectrum(nf);
+
+    double const scale = 4. / (double) seg; // same amplitude scaling as the single FFT
+
+    for (size_t i = 0; i < nf; i++)
+    {
+        double f = (double) (i + 1) / ((double) seg * dt);
+        fftx[nf - 1 - i] = 1. / f;
+        ffty[nf - 1 - i] = sqrt(power[i] / (double) nseg) * scale;
+        fftdy[nf - 1 - i] = sqrt(power[nf + i] / (double) nseg) * scale;
+    }
+
+    FinishSpectrum();
+    return true;
+}
+
+bool GARun::LombScargleSpectrum(AnalysisMonitor *mon)
+{
+    enum { OVERSAMPLE = 4 };
+
+    // the extirpolation grids are lanes of fftbuf
+    fftbuf.Reserve(LombScargleWorkSize(len, 2, OVERSAMPLE, 1.0));
+    if (!LombScargle(t, rac, decc, len, OVERSAMPLE, 1.0, fftbuf, &fftplans, &lsfreq, &lsra, &lsdec, mon))
+        return false;
+
+    size_t const n = lsfreq.size();
+    SetSpectrum(n);
+
+    // same layout as the FFT spectrum: ascending period
+    for (size_t i = 0; i < n; i++)
+    {
+        fftx[n - 1 - i] = 1. / lsfreq[i];
+        ffty[n - 1 - i] = lsra[i];
+        fftdy[n - 1 - i] = lsdec[i];
+    }
+
+    FinishSpectrum();
+    return true;
+}
+
+void Spectrogram::Swap(Spectrogram& other)
+{
+    std::swap(valid, other.valid);
+    std::swap(segment, other.segment);
+    std::swap(overlap, other.overlap);
+    std::swap(gen, other.gen);
+    std::swap(nwin, other.nwin);
+    std::swap(nf, other.nf);
+    std::swap(df, other.df);
+    std::swap(t0, other.t0);
+    std::swap(tstep, other.tstep);
+    amp[0].Swap(other.amp[0]);
+    amp[1].Swap(other.amp[1]);
+    std::swap(ampmax[0], other.ampmax[0]);
+    std::swap(ampmax[1], other.ampmax[1]);
+}
+
+static std::atomic<unsigned int> s_sgramGen;
+
+// Same windows as the Welch spectrum, but each window's spectrum is kept
+// rather than averaged. The windows are spread over the workers the same
+// way, one lane of fftbuf per worker.
+bool GARun::CalcSpectrogram(double segment, double overlap, AnalysisMonitor *mon)
+{
+    Spectrogram& sg = sgram;
+    if (sg.valid && sg.segment == segment && sg.overlap == overlap)
+        return true;
+
+    sg.valid = true;
+    sg.segment = segment;
+    sg.overlap = overlap;
+    sg.gen = ++s_sgramGen;
+    sg.nwin = 0;
+
+    size_t const n = len;
+    if (n < 2)
+        return true;
+
+    double const dt = (t[n - 1] - t[0]) / (double) (n - 1);
+    size_t const seg = FastFFTLength(std::max((size_t) 16, (size_t) (segment / dt + 0.5)));
+    if (seg > n)
+        return true;
+
+    size_t const hop = std::max((size_t) 1, (size_t) ((double) seg * (1. - overlap) + 0.5));
+    size_t const nwin = (n - seg) / hop + 1;
+    size_t const nf = seg / 2 - 1; // omit steady state f=0
+
+    sg.nwin = nwin;
+    sg.nf = nf;
+    sg.df = 1. / ((double) seg * dt);
+    sg.t0 = t[0] + 0.5 * (double) (seg - 1) * dt;
+    sg.tstep = (double) hop * dt;
+    sg.amp[0].Reserve(nwin * nf);
+    sg.amp[1].Reserve(nwin * nf);
+
+    rasp.Init(t, rac, n);
+    decsp.Init(t, decc, n);
+    const Spline *spline[2] = { &rasp, &decsp };
+    double const tmax = t[n - 1];
+    double const scale = 4. / (double) seg; // same amplitude scaling as the single FFT
+
+    size_t const ntasks = 2 * nwin;
+    size_t const nlanes = std::min((size_t) WorkerCount(), ntasks);
+    fftbuf.Reserve(nlanes * seg);
+    sgplans.Reserve(seg, nlanes);
+
+    std::atomic<size_t> next(0);
+
+    ParallelFor(nlanes, [&](size_t lane) {
+        double *const data = fftbuf + lane * seg;
+        const RealFFT& fft = sgplans[lane];
+
+        // RA windows are even tasks, Dec windows odd
+        size_t task;
+        while ((task = next++) < ntasks)
+        {
+            if (mon && mon->Cancelled())
+                break;
+
+            size_t const w = task / 2;
+            size_t const which = task % 2;
+
+            SegmentFFT(*spline[which], t[0] + (double) (w * hop) * dt, dt, tmax, fft, data);
+
+            float *const out = sg.amp[which] + w * nf;
+            for (size_t i = 0; i < nf; i++)
+                out[i] = (float) (RealFFT::Abs(data, seg, i + 1) * scale);
+        }
+    });
+
+    if (mon && mon->Cancelled())
+    {
+        sg.valid = false;
+        return false;
+    }
+
+    for (int c = 0; c < 2; c++)
+    {
+        const float *a = sg.amp[c];
+        sg.ampmax[c] = *std::max_element(a, a + nwin * nf);
+    }
+
+    return true;
+}
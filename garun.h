@@ -0,0 +1,189 @@
+/*
+ * This file is part of phdlogview
+ *
+ * Copyright (C) 2016-2018 Andy Galasso
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, visit the http://fsf.org website.
+ */
+
+#ifndef GARUN_INCLUDED
+#define GARUN_INCLUDED
+
+#include "fft.h"
+#include "parallel.h"
+
+#include <wx/datetime.h>
+#include <wx/string.h>
+
+#include <algorithm>
+#include <vector>
+
+struct GuideSession;
+
+// Heap array that only ever grows. A buffer that is reused for every
+// analysis stops allocating once it has reached the largest size needed.
+template<typename T>
+class GrowBuf
+{
+    T *m_p;
+    size_t m_cap;
+
+    GrowBuf(const GrowBuf&);
+    GrowBuf& operator=(const GrowBuf&);
+
+public:
+    GrowBuf() : m_p(nullptr), m_cap(0) { }
+    ~GrowBuf() { delete[] m_p; }
+
+    // make room for n elements; the contents are lost if the buffer grows
+    T *Reserve(size_t n)
+    {
+        if (n > m_cap)
+        {
+            delete[] m_p;
+            m_p = new T[n];
+            m_cap = n;
+        }
+        return m_p;
+    }
+    size_t Capacity() const { return m_cap; }
+    T *Data() const { return m_p; }
+    operator T *() const { return m_p; }
+    void Swap(GrowBuf& other)
+    {
+        std::swap(m_p, other.m_p);
+        std::swap(m_cap, other.m_cap);
+    }
+};
+
+class Spline
+{
+    void *spline;
+    void *accel;
+    size_t size;
+public:
+    Spline() : spline(nullptr), accel(nullptr), size(0) { }
+    Spline(const double *x, const double *y, size_t n) : spline(nullptr), accel(nullptr), size(0) { Init(x, y, n); }
+    // the GSL spline is kept when n is unchanged; GSL splines cannot be
+    // re-initialized with a different number of points
+    void Init(const double *x, const double *y, size_t n);
+    ~Spline();
+    double Eval(double x) const;
+    // does not use the lookup cache, so it can be called from several threads at once
+    double EvalNoAccel(double x) const;
+    void Swap(Spline& other);
+};
+
+enum SpectrumMode
+{
+    SPECTRUM_FFT,           // FFT of the spline-resampled series
+    SPECTRUM_LOMB_SCARGLE,  // Lomb-Scargle periodogram of the raw samples
+    SPECTRUM_WELCH,         // average of the FFTs of overlapping segments
+};
+
+struct SpectrumOptions
+{
+    SpectrumMode mode;
+    double segment;     // Welch segment length, seconds
+    double overlap;     // Welch segment overlap, fraction of a segment
+};
+
+// short-time spectra of the drift-corrected RA and Dec over sliding windows
+struct Spectrogram
+{
+    bool valid;
+    double segment;     // settings it was computed for
+    double overlap;
+    unsigned int gen;   // changes every time it is computed
+    size_t nwin;        // number of windows, 0 if the run is shorter than one window
+    size_t nf;          // frequencies per window, bin k is frequency (k + 1) * df
+    double df;
+    double t0;          // time of the center of the first window
+    double tstep;       // time between window centers
+    GrowBuf<float> amp[2]; // RA and Dec amplitudes, nwin rows of nf bins
+    float ampmax[2];
+
+    Spectrogram() : valid(false), gen(0), nwin(0), nf(0) { }
+    void Swap(Spectrogram& other);
+};
+
+struct GARun
+{
+    wxDateTime starts;
+    double pixscale;
+    size_t len;
+    GrowBuf<double> t;
+    GrowBuf<double> ra;   // RA as loaded
+    GrowBuf<double> dec;  // Dec as loaded
+    GrowBuf<double> rac;  // drift-corrected RA
+    GrowBuf<double> decc; // drift-corrected Dec
+    size_t nfft;
+    GrowBuf<double> fftx; // FFT period
+    GrowBuf<double> ffty; // FFT amplitude, RA
+    GrowBuf<double> fftdy; // FFT amplitude, Dec
+    Spline ffts;  // FFT spline for graphing, RA
+    Spline fftds; // FFT spline for graphing, Dec
+    double fftymax; // max amplitude of RA and Dec
+    // scratch space, kept between runs
+    GrowBuf<double> fftbuf; // FFT input/output for RA and Dec
+    Spline rasp, decsp;     // splines for resampling RA and Dec
+    RealFFTLanes fftplans;  // FFT plans of the spectrum
+    RealFFTLanes sgplans;   // FFT plans of the spectrogram
+    std::vector<double> lsfreq, lsra, lsdec; // Lomb-Scargle output
+    Spectrogram sgram; // computed on demand, by the worker
+    GARun() : len(0), nfft(0), fftymax(0.) { }
+    static bool CanAnalyze(const GuideSession& session, size_t begin, size_t end);
+    // copy the included frames of session[begin, end); cheap, so it can be done
+    // on the UI thread leaving the rest of the analysis to a worker
+    void Load(const GuideSession& session, size_t begin, size_t end, bool undo_ra_corrections);
+    // copy the loaded data of another run
+    void LoadFrom(const GARun& src);
+    // copy the loaded data and the results of another run
+    void CopyFrom(const GARun& src);
+    // approximate heap memory used by the run
+    size_t MemSize() const;
+    // drift correction and spectrum of the loaded data; returns false if cancelled
+    bool Process(const SpectrumOptions& opts, AnalysisMonitor *mon = nullptr);
+    // recompute the spectrum of the current data; returns false if cancelled
+    bool CalcSpectrum(const SpectrumOptions& opts, AnalysisMonitor *mon = nullptr);
+    // compute sgram for the given window settings, unless it is already;
+    // returns false if cancelled, leaving sgram invalid
+    bool CalcSpectrogram(double segment, double overlap, AnalysisMonitor *mon = nullptr);
+    void Swap(GARun& other);
+private:
+    void Alloc(size_t n);
+    void FFTSpectrum();
+    bool LombScargleSpectrum(AnalysisMonitor *mon);
+    bool WelchSpectrum(double segment, double overlap, AnalysisMonitor *mon);
+    void SetSpectrum(size_t n);
+    void FinishSpectrum();
+};
+
+// Time the FFT spectrum of the n samples y at times t at length n, as it
+// used to be computed, and at the fast length used now, and compare the
+// two. Returns a line of the timing report: n, the fast length, both
+// times, the ratio of the amplitude maxima and the largest amplitude
+// difference relative to the maximum. faster, if given, is set when the
+// fast length took less time.
+wxString TimeFFTLength(const double *t, const double *y, size_t n, bool *faster = nullptr);
+// TimeFFTLength for synthetic series of prime lengths, where the exact
+// length is slowest, appending to report; returns false, logging an
+// error, if the fast length was not faster for each of them
+bool TimeFFTPrimes(wxString *report);
+// check that the FFT length for every n in [1, nmax] is the smallest
+// number >= n with no prime factors above 7; returns false, logging an
+// error, if not
+bool CheckFFTLengths(size_t nmax);
+
+#endif
@@ -628,6 +628,89 @@ SettingsDialogBase::SettingsDialogBase( wxWindow* parent, wxWindowID id, const w
 	
 	bSizer14->Add( sbSizer5, 1, wxEXPAND, 5 );
 	
+	wxStaticBoxSizer* sbSizer7;
+	sbSizer7 = new wxStaticBoxSizer( new wxStaticBox( this, wxID_ANY, wxT("Outliers") ), wxVERTICAL );
+	
+	m_excludeOutliers = new wxCheckBox( sbSizer7->GetStaticBox(), wxID_ANY, wxT("Exclude outliers when loading a log"), wxDefaultPosition, wxDefaultSize, 0 );
+	sbSizer7->Add( m_excludeOutliers, 0, wxALL, 5 );
+	
+	wxBoxSizer* bSizer33;
+	bSizer33 = new wxBoxSizer( wxHORIZONTAL );
+	
+	m_staticText12 = new wxStaticText( sbSizer7->GetStaticBox(), wxID_ANY, wxT("Clip at"), wxDefaultPosition, wxDefaultSize, 0 );
+	m_staticText12->Wrap( -1 );
+	bSizer33->Add( m_staticText12, 0, wxALL|wxALIGN_CENTER_VERTICAL, 5 );
+	
+	m_outlierSigma = new wxTextCtrl( sbSizer7->GetStaticBox(), wxID_ANY, wxT("3.0"), wxDefaultPosition, wxSize( 45,-1 ), 0 );
+	bSizer33->Add( m_outlierSigma, 0, wxALL|wxALIGN_CENTER_VERTICAL, 5 );
+	
+	m_staticText13 = new wxStaticText( sbSizer7->GetStaticBox(), wxID_ANY, wxT("x robust sigma"), wxDefaultPosition, wxDefaultSize, 0 );
+	m_staticText13->Wrap( -1 );
+	bSizer33->Add( m_staticText13, 0, wxALL|wxALIGN_CENTER_VERTICAL, 5 );
+	
+	
+	sbSizer7->Add( bSizer33, 0, wxEXPAND, 5 );
+	
+	wxBoxSizer* bSizer34;
+	bSizer34 = new wxBoxSizer( wxHORIZONTAL );
+	
+	m_staticText14 = new wxStaticText( sbSizer7->GetStaticBox(), wxID_ANY, wxT("Up to"), wxDefaultPosition, wxDefaultSize, 0 );
+	m_staticText14->Wrap( -1 );
+	bSizer34->Add( m_staticText14, 0, wxALL|wxALIGN_CENTER_VERTICAL, 5 );
+	
+	m_outlierIters = new wxTextCtrl( sbSizer7->GetStaticBox(), wxID_ANY, wxT("5"), wxDefaultPosition, wxSize( 40,-1 ), 0 );
+	bSizer34->Add( m_outlierIters, 0, wxALL|wxALIGN_CENTER_VERTICAL, 5 );
+	
+	m_staticText15 = new wxStaticText( sbSizer7->GetStaticBox(), wxID_ANY, wxT("iterations"), wxDefaultPosition, wxDefaultSize, 0 );
+	m_staticText15->Wrap( -1 );
+	bSizer34->Add( m_staticText15, 0, wxALL|wxALIGN_CENTER_VERTICAL, 5 );
+	
+	
+	sbSizer7->Add( bSizer34, 0, wxEXPAND, 5 );
+	
+	
+	bSizer14->Add( sbSizer7, 0, wxEXPAND, 5 );
+	
+	wxStaticBoxSizer* sbSizer8;
+	sbSizer8 = new wxStaticBoxSizer( new wxStaticBox( this, wxID_ANY, wxT("Welch Spectrum") ), wxVERTICAL );
+	
+	wxBoxSizer* bSizer35;
+	bSizer35 = new wxBoxSizer( wxHORIZONTAL );
+	
+	m_staticText16 = new wxStaticText( sbSizer8->GetStaticBox(), wxID_ANY, wxT("Segment length"), wxDefaultPosition, wxDefaultSize, 0 );
+	m_staticText16->Wrap( -1 );
+	bSizer35->Add( m_staticText16, 0, wxALL|wxALIGN_CENTER_VERTICAL, 5 );
+	
+	m_welchSegment = new wxTextCtrl( sbSizer8->GetStaticBox(), wxID_ANY, wxT("600"), wxDefaultPosition, wxSize( 45,-1 ), 0 );
+	bSizer35->Add( m_welchSegment, 0, wxALL|wxALIGN_CENTER_VERTICAL, 5 );
+	
+	m_staticText17 = new wxStaticText( sbSizer8->GetStaticBox(), wxID_ANY, wxT("seconds"), wxDefaultPosition, wxDefaultSize, 0 );
+	m_staticText17->Wrap( -1 );
+	bSizer35->Add( m_staticText17, 0, wxALL|wxALIGN_CENTER_VERTICAL, 5 );
+	
+	
+	sbSizer8->Add( bSizer35, 0, wxEXPAND, 5 );
+	
+	wxBoxSizer* bSizer36;
+	bSizer36 = new wxBoxSizer( wxHORIZONTAL );
+	
+	m_staticText18 = new wxStaticText( sbSizer8->GetStaticBox(), wxID_ANY, wxT("Overlap"), wxDefaultPosition, wxDefaultSize, 0 );
+	m_staticText18->Wrap( -1 );
+	bSizer36->Add( m_staticText18, 0, wxALL|wxALIGN_CENTER_VERTICAL, 5 );
+	
+	m_welchOverlap = new wxTextCtrl( sbSizer8->GetStaticBox(), wxID_ANY, wxT("50"), wxDefaultPosition, wxSize( 40,-1 ), 0 );
+	bSizer36->Add( m_welchOverlap, 0, wxALL|wxALIGN_CENTER_VERTICAL, 5 );
+	
+	m_staticText19 = new wxStaticText( sbSizer8->GetStaticBox(), wxID_ANY, wxT("%"), wxDefaultPosition, wxDefaultSize, 0 );
+	m_staticText19->Wrap( -1 );
+	bSizer36->Add( m_staticText19, 0, wxALL|wxALIGN_CENTER_VERTICAL, 5 );
+	
+	
+	sbSizer8->Add( bSizer36, 0, wxEXPAND, 5 );
+	
+	
+	bSizer14->Add( sbSizer8, 0, wxEXPAND, 5 );
+	
 	wxStaticBoxSizer* sbSizer6;
 	sbSizer6 = new wxStaticBoxSizer( new wxStaticBox( this, wxID_ANY, wxT("Colors") ), wxHORIZONTAL );
 	
@@ -700,6 +783,19 @@ AnalyzeFrameBase::AnalyzeFrameBase( wxWindow* parent, wxWindowID id, const wxStr
 	m_toggleFFT = new wxToggleButton( this, wxID_ANY, wxT("Frequency Analysis"), wxDefaultPosition, wxDefaultSize, 0 );
 	bSizer27->Add( m_toggleFFT, 0, wxALL, 5 );
 	
+	m_toggleSpectrogram = new wxToggleButton( this, wxID_ANY, wxT("Spectrogram"), wxDefaultPosition, wxDefaultSize, 0 );
+	m_toggleSpectrogram->SetToolTip( wxT("Spectrum of sliding windows over time, using the Welch segment settings") );
+	
+	bSizer27->Add( m_toggleSpectrogram, 0, wxALL, 5 );
+	
+	wxString m_spectrumChoices[] = { wxT("FFT"), wxT("Lomb-Scargle"), wxT("Welch") };
+	int m_spectrumNChoices = sizeof( m_spectrumChoices ) / sizeof( wxString );
+	m_spectrum = new wxRadioBox( this, wxID_ANY, wxT("Spectrum"), wxDefaultPosition, wxDefaultSize, m_spectrumNChoices, m_spectrumChoices, 1, wxRA_SPECIFY_ROWS );
+	m_spectrum->SetSelection( 0 );
+	m_spectrum->SetToolTip( wxT("Spectrum estimate used for the frequency analysis") );
+	
+	bSizer27->Add( m_spectrum, 0, wxALIGN_CENTER_VERTICAL|wxLEFT|wxRIGHT, 5 );
+	
 	
 	bSizer25->Add( bSizer27, 0, 0, 5 );
 	
@@ -783,6 +879,9 @@ AnalyzeFrameBase::AnalyzeFrameBase( wxWindow* parent, wxWindowID id, const wxStr
 	m_toggleDrift->Connect( wxEVT_COMMAND_TOGGLEBUTTON_CLICKED, wxCommandEventHandler( AnalyzeFrameBase::OnClickDrift ), NULL, this );
 	m_toggleFFT->Connect( wxEVT_LEFT_DOWN, wxMouseEventHandler( AnalyzeFrameBase::OnBtnLeftDown ), NULL, this );
 	m_toggleFFT->Connect( wxEVT_COMMAND_TOGGLEBUTTON_CLICKED, wxCommandEventHandler( AnalyzeFrameBase::OnClickFFT ), NULL, this );
+	m_toggleSpectrogram->Connect( wxEVT_LEFT_DOWN, wxMouseEventHandler( AnalyzeFrameBase::OnBtnLeftDown ), NULL, this );
+	m_toggleSpectrogram->Connect( wxEVT_COMMAND_TOGGLEBUTTON_CLICKED, wxCommandEventHandler( AnalyzeFrameBase::OnClickSpectrogram ), NULL, this );
+	m_spectrum->Connect( wxEVT_COMMAND_RADIOBOX_SELECTED, wxCommandEventHandler( AnalyzeFrameBase::OnSpectrum ), NULL, this );
 	m_graph->Connect( wxEVT_LEFT_DOWN, wxMouseEventHandler( AnalyzeFrameBase::OnLeftDown ), NULL, this );
 	m_graph->Connect( wxEVT_LEFT_UP, wxMouseEventHandler( AnalyzeFrameBase::OnLeftUp ), NULL, this );
 	m_graph->Connect( wxEVT_MOTION, wxMouseEventHandler( AnalyzeFrameBase::OnMove ), NULL, this );
@@ -807,6 +906,9 @@ AnalyzeFrameBase::~AnalyzeFrameBase()
 	m_toggleDrift->Disconnect( wxEVT_COMMAND_TOGGLEBUTTON_CLICKED, wxCommandEventHandler( AnalyzeFrameBase::OnClickDrift ), NULL, this );
 	m_toggleFFT->Disconnect( wxEVT_LEFT_DOWN, wxMouseEventHandler( AnalyzeFrameBase::OnBtnLeftDown ), NULL, this );
 	m_toggleFFT->Disconnect( wxEVT_COMMAND_TOGGLEBUTTON_CLICKED, wxCommandEventHandler( AnalyzeFrameBase::OnClickFFT ), NULL, this );
+	m_toggleSpectrogram->Disconnect( wxEVT_LEFT_DOWN, wxMouseEventHandler( AnalyzeFrameBase::OnBtnLeftDown ), NULL, this );
+	m_toggleSpectrogram->Disconnect( wxEVT_COMMAND_TOGGLEBUTTON_CLICKED, wxCommandEventHandler( AnalyzeFrameBase::OnClickSpectrogram ), NULL, this );
+	m_spectrum->Disconnect( wxEVT_COMMAND_RADIOBOX_SELECTED, wxCommandEventHandler( AnalyzeFrameBase::OnSpectrum ), NULL, this );
 	m_graph->Disconnect( wxEVT_LEFT_DOWN, wxMouseEventHandler( AnalyzeFrameBase::OnLeftDown ), NULL, this );
 	m_graph->Disconnect( wxEVT_LEFT_UP, wxMouseEventHandler( AnalyzeFrameBase::OnLeftUp ), NULL, this );
 	m_graph->Disconnect( wxEVT_MOTION, wxMouseEventHandler( AnalyzeFrameBase::OnMove ), NULL, this );
@@ -155,6 +155,14 @@ class SettingsDialogBase : public wxDialog
 		wxStaticText* m_staticText4;
 		wxStaticText* m_staticText11;
 		wxStaticText* m_staticText5;
+		wxStaticText* m_staticText12;
+		wxStaticText* m_staticText13;
+		wxStaticText* m_staticText14;
+		wxStaticText* m_staticText15;
+		wxStaticText* m_staticText16;
+		wxStaticText* m_staticText17;
+		wxStaticText* m_staticText18;
+		wxStaticText* m_staticText19;
 		
 		// Virtual event handlers, overide them in your derived class
 		virtual void OnRAColor( wxCommandEvent& event ) { event.Skip(); }
@@ -166,6 +174,11 @@ class SettingsDialogBase : public wxDialog
 		wxCheckBox* m_excludeByParam;
 		wxTextCtrl* m_settlePixels;
 		wxTextCtrl* m_settleSeconds;
+		wxCheckBox* m_excludeOutliers;
+		wxTextCtrl* m_outlierSigma;
+		wxTextCtrl* m_outlierIters;
+		wxTextCtrl* m_welchSegment;
+		wxTextCtrl* m_welchOverlap;
 		wxButton* m_raColorBtn;
 		wxButton* m_decColorBtn;
 		
@@ -195,6 +208,8 @@ class AnalyzeFrameBase : public wxFrame
 		virtual void OnBtnLeftDown( wxMouseEvent& event ) { event.Skip(); }
 		virtual void OnClickDrift( wxCommandEvent& event ) { event.Skip(); }
 		virtual void OnClickFFT( wxCommandEvent& event ) { event.Skip(); }
+		virtual void OnClickSpectrogram( wxCommandEvent& event ) { event.Skip(); }
+		virtual void OnSpectrum( wxCommandEvent& event ) { event.Skip(); }
 		virtual void OnLeftDown( wxMouseEvent& event ) { event.Skip(); }
 		virtual void OnLeftUp( wxMouseEvent& event ) { event.Skip(); }
 		virtual void OnMove( wxMouseEvent& event ) { event.Skip(); }
@@ -213,6 +228,8 @@ class AnalyzeFrameBase : public wxFrame
 	public:
 		wxToggleButton* m_toggleDrift;
 		wxToggleButton* m_toggleFFT;
+		wxToggleButton* m_toggleSpectrogram;
+		wxRadioBox* m_spectrum;
 		wxPanel* m_graph;
 		wxCheckBox* m_ra;
 		wxCheckBox* m_dec;
@@ -40,6 +40,7 @@ static std::string CALIBRATION_ENDS("Calibration complete");
 static std::string XALGO("X guide algorithm = ");
 static std::string YALGO("Y guide algorithm = ");
 static std::string MINMOVE("Minimum move = ");
+static std::string EXPOSURE("Exposure = ");
 
 static char *nstrtok(char *str, const char *delims)
 {
@@ -329,26 +330,85 @@ inline static bool IsEmpty(const std::string& s)
     return s.find_first_not_of(" \t\r\n") == std::string::npos;
 }
 
-static void ParseInfo(const std::string& ln, GuideSession *s)
+// parse a pair of comma-separated numbers, like "1.23, -4.56"
+static void GetPair(const std::string& s, size_t pos, float *x, float *y)
+{
+    if (pos >= s.length())
+        return;
+    double d;
+    if (!toDouble(s.c_str() + pos, &d))
+        return;
+    *x = (float) d;
+    size_t comma = s.find(',', pos);
+    if (comma != std::string::npos && toDouble(s.c_str() + comma + 1, &d))
+        *y = (float) d;
+}
+
+static void ParseParamValue(InfoEntry& e)
+{
+    size_t pos = e.info.rfind(" = ");
+    if (pos == std::string::npos)
+        return;
+    const char *val = e.info.c_str() + pos + 3;
+    double d;
+    if (strncmp(val, "true", 4) == 0)
+        e.x = 1.f;
+    else if (strncmp(val, "false", 5) == 0)
+        e.x = 0.f;
+    else if (toDouble(val, &d))
+        e.x = (float) d;
+}
+
+static void ParseInfo(const std::string& ln, GuideSession *s, bool frame_error = false)
 {
     InfoEntry e;
     e.idx = s->entries.size();
     e.repeats = 1;
     e.info = ln.substr(INFO_KEY.length());
 
-    // trim some useless prefixes
+    // trim some useless prefixes and classify the event
     if (StartsWith(e.info, "SETTLING STATE CHANGE, "))
+    {
         e.info = e.info.substr(23);
+        if (e.info.find("Settling start") != std::string::npos)
+            e.type = INFO_SETTLE_START;
+        else if (e.info.find("Settling complete") != std::string::npos)
+            e.type = INFO_SETTLE_DONE;
+        else if (e.info.find("Settling fail") != std::string::npos)
+            e.type = INFO_SETTLE_FAIL;
+    }
     else if (StartsWith(e.info, "Guiding parameter change, "))
+    {
         e.info = e.info.substr(26);
-
-    // trim extra dither info
-    if (StartsWith(e.info, "DITHER"))
+        e.type = StartsWith(e.info, "MountGuidingEnabled = ") ? INFO_GUIDING_ENABLED : INFO_PARAM_CHANGE;
+        ParseParamValue(e);
+    }
+    else if (StartsWith(e.info, "MountGuidingEnabled = "))
     {
-        size_t pos = e.info.find(", new lock pos");
+        e.type = INFO_GUIDING_ENABLED;
+        ParseParamValue(e);
+    }
+    else if (StartsWith(e.info, "DITHER"))
+    {
+        e.type = INFO_DITHER;
+        size_t pos = e.info.find(" by ");
+        if (pos != std::string::npos)
+            GetPair(e.info, pos + 4, &e.x, &e.y);
+
+        // trim extra dither info
+        pos = e.info.find(", new lock pos");
         if (pos != std::string::npos)
             e.info = e.info.substr(0, pos);
     }
+    else if (StartsWith(e.info, "SET LOCK POS"))
+    {
+        e.type = INFO_LOCK_POS;
+        size_t pos = e.info.find(" = ");
+        if (pos != std::string::npos)
+            GetPair(e.info, pos + 3, &e.x, &e.y);
+    }
+    else if (frame_error)
+        e.type = StartsWith(e.info, "Frame dropped") ? INFO_FRAME_DROPPED : INFO_STAR_LOST;
 
     // strip extra trailing zeroes after last "."
     if (EndsWith(e.info, "00"))
@@ -382,7 +442,7 @@ static void ParseInfo(const std::string& ln, GuideSession *s)
                 return;
             }
             // coalesce set lock pos and dither
-            if (StartsWith(e.info, "DITHER") && StartsWith(prev.info, "SET LOCK POS"))
+            if (e.type == INFO_DITHER && prev.type == INFO_LOCK_POS)
             {
                 prev = e;
                 return;
@@ -471,6 +531,7 @@ static void insert_info(GuideSession& session, const GuideSession::EntryVec::ite
     InfoEntry ie;
     ie.idx = idx;
     ie.repeats = 1;
+    ie.type = INFO_TIMESTAMP_JUMP;
     ie.info = info;
     session.infos.insert(pos, ie);
 }
@@ -521,6 +582,20 @@ static void FixupNonMonotonic(GuideLog& log)
             FixupNonMonotonic(log.sessions[section.idx]);
 }
 
+static void CalcDist2(GuideLog& log)
+{
+    for (auto it = log.sessions.begin(); it != log.sessions.end(); ++it)
+    {
+        GuideSession& s = *it;
+        s.dist2.resize(s.entries.size());
+        for (size_t i = 0; i < s.entries.size(); i++)
+        {
+            const GuideEntry& e = s.entries[i];
+            s.dist2[i] = e.dx * e.dx + e.dy * e.dy;
+        }
+    }
+}
+
 bool LogParser::Parse(std::istream& is, GuideLog& log)
 {
     log.phd_version.clear();
@@ -610,6 +685,12 @@ redo:
             {
                 GetDbl(ln, "Pixel scale = ", &s->pixelScale, 1.0);
             }
+            else if (StartsWith(ln, EXPOSURE))
+            {
+                // Exposure = 2000 ms
+                GetDbl(ln, EXPOSURE, &s->exposure, 0.0);
+                s->exposure /= 1000.;
+            }
             else if (StartsWith(ln, XALGO))
             {
                 GetMinMo(ln, hdrst == MOUNT ? &s->mount.xlim : &s->ao.xlim);
@@ -672,7 +753,7 @@ redo:
 
                     // fake an info event
                     ln = "INFO: " + e.info;
-                    ParseInfo(ln, s);
+                    ParseInfo(ln, s, true);
                 }
                 else
                 {
@@ -758,6 +839,7 @@ redo:
     }
 
     FixupNonMonotonic(log);
+    CalcDist2(log);
 
     return true;
 }
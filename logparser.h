@@ -20,6 +20,8 @@
 #ifndef LOGPARSER_INCLUDED
 #define LOGPARSER_INCLUDED
 
+#include "stats.h"
+
 #include <wx/arrstr.h>
 #include <wx/datetime.h>
 #include <wx/string.h>
@@ -66,11 +68,45 @@ inline static bool StarWasFound(int err)
     }
 }
 
+// frames that count in the stats and the analyses
+inline static bool Include(const GuideEntry& e)
+{
+    return e.included && StarWasFound(e.err);
+}
+
+enum InfoType
+{
+    INFO_OTHER,
+    INFO_DITHER,            // x, y = dither amount, pixels
+    INFO_LOCK_POS,          // x, y = new lock position
+    INFO_SETTLE_START,
+    INFO_SETTLE_DONE,
+    INFO_SETTLE_FAIL,
+    INFO_STAR_LOST,
+    INFO_FRAME_DROPPED,
+    INFO_PARAM_CHANGE,      // x = new value when numeric (true/false -> 1/0)
+    INFO_GUIDING_ENABLED,   // x = 1 if mount guiding was enabled, 0 if disabled
+    INFO_TIMESTAMP_JUMP,
+};
+
 struct InfoEntry
 {
     int idx;  // index of following frame
     int repeats;
+    InfoType type;
+    float x;
+    float y;
     std::string info;
+
+    InfoEntry() : idx(0), repeats(1), type(INFO_OTHER), x(0.f), y(0.f) { }
+};
+
+// outcome of settling after a dither, as seen by the distance-based settle detector
+struct DitherSettle
+{
+    int idx;            // index of the first frame after the dither
+    int settle_idx;     // index of the frame where settling completed, -1 if it never settled
+    float settle_time;  // seconds from the dither to settled
 };
 
 enum CalDirection
@@ -139,16 +175,31 @@ struct LogSection
     LogSection(const wxString& dt) : date(dt) { }
 };
 
+// robust stats of the total error over a range of frames, pixels
+struct RangeStats
+{
+    unsigned int count;     // included frames in the range
+    double median;
+    double mad;             // median absolute deviation
+    double p90, p95, p99;
+
+    RangeStats() : count(0), median(0.), mad(0.), p90(0.), p95(0.), p99(0.) { }
+};
+
 struct GuideSession : public LogSection
 {
     typedef std::vector<GuideEntry> EntryVec;
     typedef std::vector<InfoEntry> InfoVec;
+    typedef std::vector<DitherSettle> SettleVec;
 
     double duration;
     double pixelScale;
     double declination;
+    double exposure;    // guide exposure from the header, seconds, 0 if not given
     EntryVec entries;
     InfoVec infos;
+    std::vector<float> dist2; // squared distance from the lock position for each entry, pixels^2
+    SettleVec settles;
     Mount ao;
     Mount mount;
 
@@ -165,10 +216,25 @@ struct GuideSession : public LogSection
     double drift_dec;   // pixels per minute
     double paerr;       // polar alignment error, arc-minutes
 
+    // robust stats of the total error (distance from the lock position), pixels
+    double median_err;
+    double mad_err;     // median absolute deviation
+    double p90_err, p95_err, p99_err;
+    QuantileSketch err_dist;
+
+    // accumulators kept for merging into the whole-log stats
+    LFit err_moments;       // raraw, decraw
+    double exp_time;        // total exposure of the included frames, seconds
+    double exp_err2;        // exposure-weighted sum of the squared total error
+    double exp_rms;         // exposure-weighted rms total error, pixels
+
     GraphInfo m_ginfo;
 
-    GuideSession(const wxString& dt) : LogSection(dt), duration(0.), pixelScale(1.), declination(0.), rms_ra(0.), rms_dec(0.), drift_ra(0.), drift_dec(0.) { }
+    GuideSession(const wxString& dt) : LogSection(dt), duration(0.), pixelScale(1.), declination(0.), exposure(0.), rms_ra(0.), rms_dec(0.), drift_ra(0.), drift_dec(0.),
+        median_err(0.), mad_err(0.), p90_err(0.), p95_err(0.), p99_err(0.), exp_time(0.), exp_err2(0.), exp_rms(0.) { }
     void CalcStats();
+    // stats of the included frames in entries[begin, end)
+    void CalcRangeStats(size_t begin, size_t end, RangeStats& st) const;
 };
 
 struct CalDisplay
@@ -213,6 +279,17 @@ struct GuideLog
     SessionVec sessions;
     CalibrationVec calibrations;
     SectionLocVec sections;
+
+    // stats over all guiding sessions, in the pixel scale of the longest session
+    GuideSession summary;
+    bool summary_mad_valid;
+
+    GuideLog() : summary(wxEmptyString), summary_mad_valid(false) { }
+    // merge the per-session accumulators, call after any session's CalcStats
+    void CalcSummary();
+    // the whole-log MAD, which takes a pass over every frame, so it is only
+    // computed when it is shown
+    void CalcSummaryMAD();
 };
 
 class LogParser
@@ -0,0 +1,180 @@
+/*
+ * This file is part of phdlogview
+ *
+ * Copyright (C) 2026 Andy Galasso
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, visit the http://fsf.org website.
+ */
+
+#include "minmax.h"
+
+#include <algorithm>
+
+// entries between checks of the cancel flag
+static const size_t CANCEL_CHECK = 65536;
+
+bool MinMaxPyramid::Build(const GuideSession::EntryVec& entries, const std::atomic<bool>& cancel)
+{
+    m_count = 0;
+    m_levels.clear();
+
+    size_t n = entries.size();
+    if (n == 0)
+        return true;
+
+    // level 0 from the entries, the last block may be partial
+    {
+        m_levels.push_back(Level());
+        Level& lv = m_levels.back();
+        lv.size = (n + BASE_BLOCK - 1) / BASE_BLOCK;
+        for (int c = 0; c < NUM_COLUMNS; c++)
+        {
+            lv.lo[c].resize(lv.size);
+            lv.hi[c].resize(lv.size);
+        }
+
+        for (size_t b = 0; b < lv.size; b++)
+        {
+            if ((b * BASE_BLOCK) % CANCEL_CHECK == 0 && cancel)
+            {
+                m_levels.clear();
+                return false;
+            }
+
+            size_t i0 = b * BASE_BLOCK;
+            size_t i1 = std::min(i0 + BASE_BLOCK, n);
+            for (int c = 0; c < NUM_COLUMNS; c++)
+            {
+                float lo = Value(entries[i0], c);
+                float hi = lo;
+                for (size_t i = i0 + 1; i < i1; i++)
+                {
+                    float v = Value(entries[i], c);
+                    if (v < lo)
+                        lo = v;
+                    else if (v > hi)
+                        hi = v;
+                }
+                lv.lo[c][b] = lo;
+                lv.hi[c][b] = hi;
+            }
+        }
+    }
+
+    // pair up blocks until a single block covers everything
+    while (m_levels.back().size > 1)
+    {
+        if (cancel)
+        {
+            m_levels.clear();
+            return false;
+        }
+
+        m_levels.push_back(Level());
+        const Level& prev = m_levels[m_levels.size() - 2];
+        Level& lv = m_levels.back();
+        lv.size = (prev.size + 1) / 2;
+        for (int c = 0; c < NUM_COLUMNS; c++)
+        {
+            lv.lo[c].resize(lv.size);
+            lv.hi[c].resize(lv.size);
+            const float *plo = &prev.lo[c][0];
+            const float *phi = &prev.hi[c][0];
+            for (size_t b = 0; b < lv.size; b++)
+            {
+                size_t k = 2 * b;
+                if (k + 1 < prev.size)
+                {
+                    lv.lo[c][b] = std::min(plo[k], plo[k + 1]);
+                    lv.hi[c][b] = std::max(phi[k], phi[k + 1]);
+                }
+                else
+                {
+                    lv.lo[c][b] = plo[k];
+                    lv.hi[c][b] = phi[k];
+                }
+            }
+        }
+    }
+
+    m_count = n;
+    return true;
+}
+
+size_t MinMaxPyramid::MemSize() const
+{
+    size_t sz = sizeof(*this);
+    for (auto it = m_levels.begin(); it != m_levels.end(); ++it)
+        sz += sizeof(*it) + it->size * NUM_COLUMNS * 2 * sizeof(float);
+    return sz;
+}
+
+void MinMaxPyramid::MinMax(const GuideSession::EntryVec& entries, int col, size_t i0, size_t i1, float *plo, float *phi) const
+{
+    float lo = Value(entries[i0], col);
+    float hi = lo;
+
+    // raw entries up to the first block boundary
+    size_t b0 = (i0 + BASE_BLOCK - 1) / BASE_BLOCK;
+    size_t b1 = i1 / BASE_BLOCK;
+    if (b0 >= b1)
+    {
+        // the range does not contain a whole block
+        for (size_t i = i0 + 1; i < i1; i++)
+        {
+            float v = Value(entries[i], col);
+            lo = std::min(lo, v);
+            hi = std::max(hi, v);
+        }
+        *plo = lo;
+        *phi = hi;
+        return;
+    }
+
+    for (size_t i = i0 + 1; i < b0 * BASE_BLOCK; i++)
+    {
+        float v = Value(entries[i], col);
+        lo = std::min(lo, v);
+        hi = std::max(hi, v);
+    }
+    for (size_t i = b1 * BASE_BLOCK; i < i1; i++)
+    {
+        float v = Value(entries[i], col);
+        lo = std::min(lo, v);
+        hi = std::max(hi, v);
+    }
+
+    // whole blocks [b0, b1), climbing a level whenever the ends pair up
+    for (size_t l = 0; b0 < b1; l++)
+    {
+        const Level& lv = m_levels[l];
+        if (b0 & 1)
+        {
+            lo = std::min(lo, lv.lo[col][b0]);
+            hi = std::max(hi, lv.hi[col][b0]);
+            ++b0;
+        }
+        if (b1 & 1)
+        {
+            --b1;
+            lo = std::min(lo, lv.lo[col][b1]);
+            hi = std::max(hi, lv.hi[col][b1]);
+        }
+        b0 /= 2;
+        b1 /= 2;
+    }
+
+    *plo = lo;
+    *phi = hi;
+}
@@ -0,0 +1,98 @@
+/*
+ * This file is part of phdlogview
+ *
+ * Copyright (C) 2026 Andy Galasso
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, visit the http://fsf.org website.
+ */
+
+#ifndef MINMAX_INCLUDED
+#define MINMAX_INCLUDED
+
+#include "logparser.h"
+
+#include <atomic>
+#include <vector>
+
+// Multi-resolution min/max summary of the plotted guide graph columns.
+//
+// Level 0 holds the min and max of each block of BASE_BLOCK entries, and
+// each higher level combines pairs of blocks of the level below. The min
+// and max over any range of entries can then be found by visiting
+// O(log n) blocks plus at most two partial blocks of raw entries, so
+// drawing a zoomed-out graph costs the same whatever the session length.
+class MinMaxPyramid
+{
+public:
+    enum Column
+    {
+        COL_RA,     // raraw
+        COL_DEC,    // decraw
+        COL_DX,
+        COL_DY,
+        COL_MASS,
+        COL_SNR,
+        COL_RADUR_MOUNT,    // radur of the mount entries, 0 for AO entries
+        COL_RADUR_AO,
+        COL_DECDUR_MOUNT,
+        COL_DECDUR_AO,
+        NUM_COLUMNS,
+    };
+
+    enum { BASE_BLOCK = 8 };
+
+    static float Value(const GuideEntry& e, int col);
+
+    MinMaxPyramid() : m_count(0) { }
+
+    // build the summary of entries; returns false if cancelled, which
+    // leaves the pyramid empty
+    bool Build(const GuideSession::EntryVec& entries, const std::atomic<bool>& cancel);
+    // number of entries summarized, 0 if the pyramid has not been built
+    size_t Count() const { return m_count; }
+    size_t MemSize() const;
+
+    // min and max of column col over entries [i0, i1); entries must be
+    // the vector the pyramid was built from, and i0 < i1 <= Count()
+    void MinMax(const GuideSession::EntryVec& entries, int col, size_t i0, size_t i1, float *lo, float *hi) const;
+
+private:
+    struct Level
+    {
+        size_t size;                       // blocks
+        std::vector<float> lo[NUM_COLUMNS];
+        std::vector<float> hi[NUM_COLUMNS];
+    };
+
+    size_t m_count;
+    std::vector<Level> m_levels;
+};
+
+inline float MinMaxPyramid::Value(const GuideEntry& e, int col)
+{
+    switch (col) {
+    case COL_RA: return e.raraw;
+    case COL_DEC: return e.decraw;
+    case COL_DX: return e.dx;
+    case COL_DY: return e.dy;
+    case COL_MASS: return (float) e.mass;
+    case COL_SNR: return e.snr;
+    case COL_RADUR_MOUNT: return e.mount == MOUNT ? (float) e.radur : 0.f;
+    case COL_RADUR_AO: return e.mount == AO ? (float) e.radur : 0.f;
+    case COL_DECDUR_MOUNT: return e.mount == MOUNT ? (float) e.decdur : 0.f;
+    default: return e.mount == AO ? (float) e.decdur : 0.f;
+    }
+}
+
+#endif
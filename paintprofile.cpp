@@ -0,0 +1,162 @@
+/*
+ * This file is part of phdlogview
+ *
+ * Copyright (C) 2026 Andy Galasso
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, visit the http://fsf.org website.
+ */
+
+#include "paintprofile.h"
+
+#include <algorithm>
+#include <string.h>
+
+// upper bounds of the histogram buckets, ms; the last bucket is open
+static const double BUCKET_MS[PaintProfile::NUM_BUCKETS - 1] = { 1, 2, 4, 8, 16, 33, 66 };
+static const char *const BUCKET_LABEL[PaintProfile::NUM_BUCKETS] =
+{
+    "<1", "<2", "<4", "<8", "<16", "<33", "<66", "66+",
+};
+
+PaintProfile::PaintProfile()
+    :
+    m_shown(false),
+    m_mark(0),
+    m_ncur(0),
+    m_points(0),
+    m_nlast(0),
+    m_lastMs(0.),
+    m_lastPoints(0),
+    m_nhist(0),
+    m_next(0)
+{
+}
+
+void PaintProfile::Begin()
+{
+    m_ncur = 0;
+    m_points = 0;
+    m_sw.Start();
+    m_mark = 0;
+}
+
+void PaintProfile::Mark(const char *section)
+{
+    wxLongLong now = m_sw.TimeInMicro();
+    double ms = (now - m_mark).ToDouble() / 1000.;
+    m_mark = now;
+
+    // sections can be visited more than once per paint; the names are
+    // compared by content since equal literals need not share an address
+    for (int i = 0; i < m_ncur; i++)
+    {
+        if (strcmp(m_cur[i].name, section) == 0)
+        {
+            m_cur[i].ms += ms;
+            return;
+        }
+    }
+    if (m_ncur < MAX_SECTIONS)
+    {
+        m_cur[m_ncur].name = section;
+        m_cur[m_ncur].ms = ms;
+        ++m_ncur;
+    }
+}
+
+void PaintProfile::End()
+{
+    std::copy(m_cur, m_cur + m_ncur, m_last);
+    m_nlast = m_ncur;
+    m_lastMs = m_sw.TimeInMicro().ToDouble() / 1000.;
+    m_lastPoints = m_points;
+
+    m_history[m_next] = m_lastMs;
+    m_next = (m_next + 1) % HISTORY;
+    if (m_nhist < HISTORY)
+        ++m_nhist;
+}
+
+void PaintProfile::Histogram(unsigned int counts[NUM_BUCKETS]) const
+{
+    std::fill(counts, counts + NUM_BUCKETS, 0);
+    for (unsigned int i = 0; i < m_nhist; i++)
+    {
+        int b = 0;
+        while (b < NUM_BUCKETS - 1 && m_history[i] >= BUCKET_MS[b])
+            ++b;
+        ++counts[b];
+    }
+}
+
+void PaintProfile::Draw(wxDC& dc) const
+{
+    int const lh = dc.GetCharHeight();
+    int const BARW = 60;
+    int const x0 = 6, y0 = 20;
+    int const nlines = 1 + m_nlast + 1 + NUM_BUCKETS;
+    int const w = dc.GetTextExtent("paint 000.00 ms, 0000000 points").x + 8;
+
+    dc.SetPen(*wxGREY_PEN);
+    dc.SetBrush(*wxBLACK_BRUSH);
+    dc.DrawRectangle(x0 - 4, y0 - 4, w, nlines * lh + 8);
+    dc.SetTextForeground(*wxWHITE);
+
+    int y = y0;
+    dc.DrawText(wxString::Format("paint %.2f ms, %u points", m_lastMs, m_lastPoints), x0, y);
+    y += lh;
+    for (int i = 0; i < m_nlast; i++, y += lh)
+        dc.DrawText(wxString::Format("  %s %.2f ms", m_last[i].name, m_last[i].ms), x0, y);
+
+    unsigned int counts[NUM_BUCKETS];
+    Histogram(counts);
+    unsigned int maxcnt = std::max(*std::max_element(counts, counts + NUM_BUCKETS), 1u);
+
+    dc.DrawText(wxString::Format("last %u paints", m_nhist), x0, y);
+    y += lh;
+    int const bx = x0 + dc.GetTextExtent("66+ ms").x + 6;
+    dc.SetPen(*wxTRANSPARENT_PEN);
+    dc.SetBrush(*wxGREEN_BRUSH);
+    for (int b = 0; b < NUM_BUCKETS; b++, y += lh)
+    {
+        dc.DrawText(wxString::Format("%s ms", BUCKET_LABEL[b]), x0, y);
+        int len = (int)((double) BARW * counts[b] / maxcnt);
+        if (len > 0)
+            dc.DrawRectangle(bx, y + 2, len, lh - 4);
+        if (counts[b])
+            dc.DrawText(wxString::Format("%u", counts[b]), bx + len + 3, y);
+    }
+}
+
+wxString PaintProfile::Report() const
+{
+    wxString s;
+    s << wxString::Format("paint %.3f ms, %u points\n", m_lastMs, m_lastPoints);
+    for (int i = 0; i < m_nlast; i++)
+        s << wxString::Format("%s %.3f ms\n", m_last[i].name, m_last[i].ms);
+
+    unsigned int counts[NUM_BUCKETS];
+    Histogram(counts);
+    s << wxString::Format("paint time histogram, last %u paints\n", m_nhist);
+    for (int b = 0; b < NUM_BUCKETS; b++)
+        s << wxString::Format("%s ms %u\n", BUCKET_LABEL[b], counts[b]);
+
+    // oldest first
+    s << "recent paint times, ms\n";
+    unsigned int start = (m_next + HISTORY - m_nhist) % HISTORY;
+    for (unsigned int i = 0; i < m_nhist; i++)
+        s << wxString::Format(i + 1 < m_nhist ? "%.2f," : "%.2f\n", m_history[(start + i) % HISTORY]);
+
+    return s;
+}
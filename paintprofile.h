@@ -0,0 +1,84 @@
+/*
+ * This file is part of phdlogview
+ *
+ * Copyright (C) 2026 Andy Galasso
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, visit the http://fsf.org website.
+ */
+
+#ifndef PAINTPROFILE_INCLUDED
+#define PAINTPROFILE_INCLUDED
+
+#include <wx/dc.h>
+#include <wx/stopwatch.h>
+#include <wx/string.h>
+
+// Timing of the paints of a graph window.
+//
+// A paint is split into named sections with Mark(); only the sections
+// that ran are reported, so a layer served from a cache does not show
+// up. The last paint's breakdown and a histogram of the recent paint
+// times can be drawn over the graph and copied as text for bug reports.
+class PaintProfile
+{
+public:
+    enum { MAX_SECTIONS = 12, HISTORY = 120, NUM_BUCKETS = 8 };
+
+    PaintProfile();
+
+    bool IsShown() const { return m_shown; }
+    void Toggle() { m_shown = !m_shown; }
+
+    // start timing a paint
+    void Begin();
+    // charge the time since Begin() or the previous Mark() to section
+    void Mark(const char *section);
+    // count vertices or points handed to the dc
+    void AddPoints(unsigned int n) { m_points += n; }
+    // finish timing the paint
+    void End();
+
+    // draw the numbers in the top left corner of the graph
+    void Draw(wxDC& dc) const;
+    // the numbers as plain text
+    wxString Report() const;
+
+private:
+    struct Section
+    {
+        const char *name;
+        double ms;
+    };
+
+    wxStopWatch m_sw;
+    bool m_shown;
+    wxLongLong m_mark;
+
+    Section m_cur[MAX_SECTIONS];    // paint in progress
+    int m_ncur;
+    unsigned int m_points;
+
+    Section m_last[MAX_SECTIONS];   // last finished paint
+    int m_nlast;
+    double m_lastMs;
+    unsigned int m_lastPoints;
+
+    double m_history[HISTORY];      // ring buffer of paint times, ms
+    unsigned int m_nhist;
+    unsigned int m_next;
+
+    void Histogram(unsigned int counts[NUM_BUCKETS]) const;
+};
+
+#endif
@@ -0,0 +1,183 @@
+/*
+ * This file is part of phdlogview
+ *
+ * Copyright (C) 2026 Andy Galasso
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, visit the http://fsf.org website.
+ */
+
+#include "parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+unsigned int WorkerCount()
+{
+    unsigned int n = std::thread::hardware_concurrency();
+    return n ? n : 1;
+}
+
+namespace
+{
+    // a ParallelFor call, on the caller's stack
+    struct Job
+    {
+        void (*fn)(void *ctx, size_t i);
+        void *ctx;
+        size_t n;
+        std::atomic<size_t> next;   // next index to claim
+        unsigned int users;         // workers running calls, under the pool lock
+        Job *link;                  // next job in the queue
+    };
+
+    // Worker threads waiting for jobs. A job stays in the queue until its
+    // last index is claimed; any number of workers can join it. The caller
+    // claims indexes too, then waits until no worker is still running one,
+    // so a job never has to wait for a worker that is busy elsewhere and
+    // nested calls cannot deadlock.
+    class Pool
+    {
+        std::mutex m_lock;
+        std::condition_variable m_work;
+        std::condition_variable m_idle;
+        Job *m_queue;
+        bool m_quit;
+        std::vector<std::thread> m_threads;
+        std::once_flag m_started;
+
+        void Start();
+        void Worker();
+        void Unlink(Job *job);
+
+    public:
+        Pool() : m_queue(nullptr), m_quit(false) { }
+        ~Pool();
+        void Run(Job& job);
+    };
+}
+
+void Pool::Start()
+{
+    unsigned int n = WorkerCount();
+    m_threads.reserve(n - 1);
+    // the calling thread does its share of the work too
+    for (unsigned int i = 1; i < n; i++)
+        m_threads.push_back(std::thread(&Pool::Worker, this));
+}
+
+Pool::~Pool()
+{
+    {
+        std::lock_guard<std::mutex> lck(m_lock);
+        m_quit = true;
+    }
+    m_work.notify_all();
+    for (auto it = m_threads.begin(); it != m_threads.end(); ++it)
+        it->join();
+}
+
+// remove job from the queue if it is there; call with the lock held
+void Pool::Unlink(Job *job)
+{
+    for (Job **p = &m_queue; *p; p = &(*p)->link)
+    {
+        if (*p == job)
+        {
+            *p = job->link;
+            return;
+        }
+    }
+}
+
+void Pool::Worker()
+{
+    std::unique_lock<std::mutex> lck(m_lock);
+    for (;;)
+    {
+        while (!m_quit && !m_queue)
+            m_work.wait(lck);
+        if (m_quit)
+            return;
+
+        Job *job = m_queue;
+        if (job->next >= job->n)
+        {
+            // fully claimed, the caller and the workers in it finish it
+            Unlink(job);
+            continue;
+        }
+        ++job->users;
+        lck.unlock();
+
+        size_t i;
+        while ((i = job->next++) < job->n)
+            job->fn(job->ctx, i);
+
+        lck.lock();
+        Unlink(job);
+        // the caller may return as soon as this is 0, so job must not be
+        // touched after it
+        if (--job->users == 0)
+            m_idle.notify_all();
+    }
+}
+
+void Pool::Run(Job& job)
+{
+    std::call_once(m_started, &Pool::Start, this);
+
+    {
+        std::lock_guard<std::mutex> lck(m_lock);
+        job.link = m_queue;
+        m_queue = &job;
+    }
+    m_work.notify_all();
+
+    size_t i;
+    while ((i = job.next++) < job.n)
+        job.fn(job.ctx, i);
+
+    std::unique_lock<std::mutex> lck(m_lock);
+    Unlink(&job);
+    while (job.users)
+        m_idle.wait(lck);
+}
+
+static Pool s_pool;
+
+void ParallelFor(size_t n, void (*fn)(void *ctx, size_t i), void *ctx)
+{
+    if (n == 0)
+        return;
+
+    if (n == 1 || WorkerCount() <= 1)
+    {
+        for (size_t i = 0; i < n; i++)
+            fn(ctx, i);
+        return;
+    }
+
+    Job job;
+    job.fn = fn;
+    job.ctx = ctx;
+    job.n = n;
+    job.next = 0;
+    job.users = 0;
+    job.link = nullptr;
+    s_pool.Run(job);
+}
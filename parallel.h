@@ -0,0 +1,57 @@
+/*
+ * This file is part of phdlogview
+ *
+ * Copyright (C) 2026 Andy Galasso
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, visit the http://fsf.org website.
+ */
+
+#ifndef PARALLEL_INCLUDED
+#define PARALLEL_INCLUDED
+
+#include <stddef.h>
+
+// lets a background analysis report progress and notice that it has
+// been cancelled; both may be called from any thread
+class AnalysisMonitor
+{
+public:
+    virtual ~AnalysisMonitor() { }
+    virtual bool Cancelled() const = 0;
+    virtual void Progress(int percent) = 0;
+};
+
+// Number of worker threads to use for parallel loops
+unsigned int WorkerCount();
+
+// Call fn(ctx, i) for every i in [0, n), spreading the calls over a pool
+// of worker threads that is started on first use and kept for the life of
+// the process. Returns when all calls have completed. fn must not touch
+// any GUI objects. It may call ParallelFor itself; the nested loop is
+// shared with the workers that are free and the caller does the rest.
+// Once the pool is running a call does not allocate.
+void ParallelFor(size_t n, void (*fn)(void *ctx, size_t i), void *ctx);
+
+// ParallelFor for a function object, usually a lambda, called as fn(i)
+template<typename F>
+inline void ParallelFor(size_t n, const F& fn)
+{
+    struct Call
+    {
+        static void Run(void *ctx, size_t i) { (*static_cast<const F *>(ctx))(i); }
+    };
+    ParallelFor(n, &Call::Run, const_cast<F *>(&fn));
+}
+
+#endif
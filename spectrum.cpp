@@ -0,0 +1,212 @@
+/*
+ * This file is part of phdlogview
+ *
+ * Copyright (C) 2026 Andy Galasso
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, visit the http://fsf.org website.
+ */
+
+#include "spectrum.h"
+
+#include "fft.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <math.h>
+
+enum { MACC = 4 }; // number of grid points each sample is extirpolated onto
+
+// Add y to the array yy[0..n) as if it were at the non-integer position x,
+// such that interpolating yy back to x (with Lagrange polynomials of order
+// MACC) gives y
+static void Spread(double y, double *yy, int n, double x)
+{
+    static const int nfac[] = { 1, 1, 2, 6, 24, 120, 720, 5040, 40320, 362880 };
+
+    int ix = (int) x;
+    if (x == (double) ix)
+    {
+        yy[ix] += y;
+        return;
+    }
+
+    int ilo = std::min(std::max((int)(x - 0.5 * MACC + 1.0), 0), n - MACC);
+    int ihi = ilo + MACC - 1;
+    double nden = nfac[MACC - 1];
+    double fac = x - ilo;
+    for (int j = ilo + 1; j <= ihi; j++)
+        fac *= x - j;
+    yy[ihi] += y * fac / (nden * (x - ihi));
+    for (int j = ihi - 1; j >= ilo; j--)
+    {
+        nden = (nden / (j + 1 - ilo)) * (j - ihi);
+        yy[j] += y * fac / (nden * (x - j));
+    }
+}
+
+// size of the regular grids the samples are extirpolated onto
+static size_t GridSize(size_t n, double ofac, double hifac)
+{
+    size_t nfreq = 64;
+    while ((double) nfreq < ofac * hifac * (double) n * MACC)
+        nfreq <<= 1;
+    return nfreq * 2;
+}
+
+size_t LombScargleWorkSize(size_t n, size_t nser, double ofac, double hifac)
+{
+    return (nser + 1) * GridSize(n, ofac, hifac);
+}
+
+inline static bool Cancelled(const AnalysisMonitor *mon)
+{
+    return mon && mon->Cancelled();
+}
+
+// periodograms of nser series sampled at the same times t; the transform
+// of the weights depends only on t, so it is shared by all the series
+static bool Periodogram(const double *t, const double *const *y, size_t nser, size_t n, double ofac, double hifac,
+                        double *work, RealFFTLanes *plans, std::vector<double> *freq, std::vector<double> *const *amp,
+                        AnalysisMonitor *mon)
+{
+    freq->clear();
+    for (size_t k = 0; k < nser; k++)
+        amp[k]->clear();
+
+    if (n < 2)
+        return true;
+
+    double const xmin = t[0];
+    double const xdif = t[n - 1] - t[0];
+    if (xdif <= 0.)
+        return true;
+
+    size_t const nout = (size_t)(0.5 * ofac * hifac * (double) n);
+
+    size_t const ndim = GridSize(n, ofac, hifac);
+
+    // extirpolate the data and the weights (at twice the frequency) onto
+    // regular grids, one lane of work for each series and the last for
+    // the weights
+    std::fill(work, work + (nser + 1) * ndim, 0.);
+    double *const wk2 = work + nser * ndim;
+    double const fac = (double) ndim / (xdif * ofac);
+    double const fndim = (double) ndim;
+    for (size_t k = 0; k < nser; k++)
+    {
+        double ave = 0.;
+        for (size_t i = 0; i < n; i++)
+            ave += y[k][i];
+        ave /= (double) n;
+
+        for (size_t i = 0; i < n; i++)
+        {
+            double ck = fmod((t[i] - xmin) * fac, fndim);
+            Spread(y[k][i] - ave, work + k * ndim, (int) ndim, ck);
+        }
+
+        if (Cancelled(mon))
+            return false;
+    }
+    for (size_t i = 0; i < n; i++)
+    {
+        double ck = fmod((t[i] - xmin) * fac, fndim);
+        double ckk = fmod(2.0 * ck, fndim);
+        Spread(1.0, wk2, (int) ndim, ckk);
+    }
+
+    // the transforms are independent; each lane needs its own plan
+    plans->Reserve(ndim, nser + 1);
+    ParallelFor(nser + 1, [work, ndim, plans](size_t k) {
+        (*plans)[k].Forward(work + k * ndim);
+    });
+
+    if (Cancelled(mon))
+        return false;
+
+    // skip frequencies with periods longer than the data
+    size_t const j0 = std::max((size_t) ceil(ofac), (size_t) 1);
+    if (nout < j0)
+        return true;
+
+    size_t const nf = nout - j0 + 1;
+    freq->resize(nf);
+    for (size_t k = 0; k < nser; k++)
+        amp[k]->resize(nf);
+
+    double const df = 1.0 / (xdif * ofac);
+    double const dn = (double) n;
+
+    enum { BLOCK = 4096 };
+    size_t const nblocks = (nf + BLOCK - 1) / BLOCK;
+
+    ParallelFor(nblocks, [&](size_t b) {
+        // a superseded request stops at the next block
+        if (Cancelled(mon))
+            return;
+
+        size_t const end = std::min(nf, (b + 1) * BLOCK);
+        for (size_t i = b * BLOCK; i < end; i++)
+        {
+            size_t const j = j0 + i;
+            // GSL half-complex order: Re at 2j-1, Im at 2j
+            double const c2 = wk2[2 * j - 1], s2 = wk2[2 * j];
+
+            double const hypo = hypot(c2, s2);
+            double hc2wt, hs2wt;
+            if (hypo > 0.)
+            {
+                hc2wt = 0.5 * c2 / hypo;
+                hs2wt = 0.5 * s2 / hypo;
+            }
+            else
+            {
+                hc2wt = 0.5;
+                hs2wt = 0.;
+            }
+            double const cwt = sqrt(0.5 + hc2wt);
+            double const swt = copysign(sqrt(std::max(0.5 - hc2wt, 0.)), hs2wt);
+            double const den = 0.5 * dn + hc2wt * c2 + hs2wt * s2;
+
+            (*freq)[i] = (double) j * df;
+
+            for (size_t k = 0; k < nser; k++)
+            {
+                const double *const wk1 = work + k * ndim;
+                double const c1 = wk1[2 * j - 1], s1 = wk1[2 * j];
+                double const cterm = den > 0. ? (cwt * c1 + swt * s1) * (cwt * c1 + swt * s1) / den : 0.;
+                double const sterm = dn - den > 0. ? (cwt * s1 - swt * c1) * (cwt * s1 - swt * c1) / (dn - den) : 0.;
+                // unnormalized power is (cterm + sterm) / 2
+                (*amp[k])[i] = sqrt(2.0 * (cterm + sterm) / dn);
+            }
+        }
+    });
+
+    return !Cancelled(mon);
+}
+
+bool LombScargle(const double *t, const double *y, size_t n, double ofac, double hifac, double *work, RealFFTLanes *plans,
+                 std::vector<double> *freq, std::vector<double> *amp, AnalysisMonitor *mon)
+{
+    return Periodogram(t, &y, 1, n, ofac, hifac, work, plans, freq, &amp, mon);
+}
+
+bool LombScargle(const double *t, const double *y1, const double *y2, size_t n, double ofac, double hifac, double *work,
+                 RealFFTLanes *plans, std::vector<double> *freq, std::vector<double> *amp1, std::vector<double> *amp2,
+                 AnalysisMonitor *mon)
+{
+    const double *y[] = { y1, y2 };
+    std::vector<double> *amp[] = { amp1, amp2 };
+    return Periodogram(t, y, 2, n, ofac, hifac, work, plans, freq, amp, mon);
+}
@@ -0,0 +1,55 @@
+/*
+ * This file is part of phdlogview
+ *
+ * Copyright (C) 2026 Andy Galasso
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, visit the http://fsf.org website.
+ */
+
+#ifndef SPECTRUM_INCLUDED
+#define SPECTRUM_INCLUDED
+
+#include <stddef.h>
+#include <vector>
+
+class AnalysisMonitor;
+class RealFFTLanes;
+
+// Lomb-Scargle periodogram of n unevenly spaced samples y at times t,
+// using the O(n log n) extirpolation method of Press & Rybicki (1989).
+//
+// Frequencies are f[i] = (i + 1) / (ofac * T) where T = t[n-1] - t[0],
+// up to hifac times the average Nyquist frequency. Only frequencies with
+// periods no longer than T are returned. The result is the amplitude of a
+// sinusoid at that frequency (2 * sqrt(P / n) for unnormalized power P),
+// in the units of y, so it is comparable to the FFT amplitude spectrum.
+//
+// work must hold LombScargleWorkSize(n, 1, ofac, hifac) doubles and plans
+// gets the FFT plans of the grids, so a caller that keeps both between
+// calls does not allocate them again. Returns false if mon was cancelled,
+// leaving the output incomplete.
+bool LombScargle(const double *t, const double *y, size_t n, double ofac, double hifac, double *work, RealFFTLanes *plans,
+                 std::vector<double> *freq, std::vector<double> *amp, AnalysisMonitor *mon = nullptr);
+
+// periodograms of two series sampled at the same times, e.g. RA and Dec;
+// cheaper than two separate calls since the weights are shared. work must
+// hold LombScargleWorkSize(n, 2, ofac, hifac) doubles.
+bool LombScargle(const double *t, const double *y1, const double *y2, size_t n, double ofac, double hifac, double *work,
+                 RealFFTLanes *plans, std::vector<double> *freq, std::vector<double> *amp1, std::vector<double> *amp2,
+                 AnalysisMonitor *mon = nullptr);
+
+// doubles of work space for the periodograms of nser series of n samples
+size_t LombScargleWorkSize(size_t n, size_t nser, double ofac, double hifac);
+
+#endif
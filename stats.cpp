@@ -0,0 +1,129 @@
+/*
+ * This file is part of phdlogview
+ *
+ * Copyright (C) 2026 Andy Galasso
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, visit the http://fsf.org website.
+ */
+
+#include "stats.h"
+
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+// bucket i >= 1 holds values in (MIN_VALUE * GAMMA^(i-1), MIN_VALUE * GAMMA^i]
+// GAMMA = (1 + a) / (1 - a) for a relative accuracy a = 1%
+static const double GAMMA = 1.01 / 0.99;
+static const double LOG_GAMMA = log(GAMMA);
+static const double MIN_VALUE = 1e-3; // pixels
+
+void QuantileSketch::Reset()
+{
+    m_count = 0;
+    memset(m_bucket, 0, sizeof(m_bucket));
+}
+
+void QuantileSketch::Add(double v)
+{
+    int i;
+    if (v <= MIN_VALUE)
+        i = 0;
+    else
+    {
+        i = (int) ceil(log(v / MIN_VALUE) / LOG_GAMMA);
+        if (i >= NBUCKETS)
+            i = NBUCKETS - 1;
+    }
+    ++m_bucket[i];
+    ++m_count;
+}
+
+void QuantileSketch::Merge(const QuantileSketch& other)
+{
+    for (int i = 0; i < NBUCKETS; i++)
+        m_bucket[i] += other.m_bucket[i];
+    m_count += other.m_count;
+}
+
+void QuantileSketch::Merge(const QuantileSketch& other, double scale)
+{
+    if (scale <= 0.)
+        return;
+
+    int shift = (int) floor(log(scale) / LOG_GAMMA + 0.5);
+    if (shift == 0)
+    {
+        Merge(other);
+        return;
+    }
+
+    // values below the resolution limit stay in bucket 0
+    m_bucket[0] += other.m_bucket[0];
+    for (int i = 1; i < NBUCKETS; i++)
+    {
+        if (!other.m_bucket[i])
+            continue;
+        int j = std::min(std::max(i + shift, 1), (int) NBUCKETS - 1);
+        m_bucket[j] += other.m_bucket[i];
+    }
+    m_count += other.m_count;
+}
+
+static double BucketValue(int i)
+{
+    // mid-point of the bucket in the relative sense
+    return i == 0 ? 0. : MIN_VALUE * 2. * pow(GAMMA, i) / (GAMMA + 1.);
+}
+
+double QuantileSketch::Quantile(double q) const
+{
+    if (m_count == 0)
+        return 0.;
+
+    double rank = q * (double)(m_count - 1);
+    unsigned int cum = 0;
+    int i = 0;
+    for (; i < NBUCKETS - 1; i++)
+    {
+        cum += m_bucket[i];
+        if ((double) cum > rank)
+            break;
+    }
+
+    return BucketValue(i);
+}
+
+void LFit::merge(const LFit& other, double scale)
+{
+    if (other.n == 0.)
+        return;
+
+    double bx = other.avx * scale;
+    double by = other.avy * scale;
+    double s2 = scale * scale;
+
+    double nn = n + other.n;
+    double dx = bx - avx;
+    double dy = by - avy;
+    double f = n * other.n / nn;
+
+    // combine the sums of squared deviations, then back to variances
+    varx = (varx * n + other.varx * other.n * s2 + dx * dx * f) / nn;
+    vary = (vary * n + other.vary * other.n * s2 + dy * dy * f) / nn;
+    covxy = (covxy * n + other.covxy * other.n * s2 + dx * dy * f) / nn;
+    avx += dx * other.n / nn;
+    avy += dy * other.n / nn;
+    n = nn;
+}
@@ -0,0 +1,91 @@
+/*
+ * This file is part of phdlogview
+ *
+ * Copyright (C) 2026 Andy Galasso
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, visit the http://fsf.org website.
+ */
+
+#ifndef STATS_INCLUDED
+#define STATS_INCLUDED
+
+#include <math.h>
+#include <stddef.h>
+
+// Quantile estimator for non-negative values (guide errors in pixels).
+//
+// Values are counted in logarithmically spaced buckets, so every quantile
+// is reported with a relative error of at most ~1% using a fixed 4KB of
+// memory regardless of the number of samples. Two sketches can be merged
+// by adding their bucket counts, which lets per-session distributions be
+// combined for whole-log numbers without revisiting the frames.
+class QuantileSketch
+{
+public:
+    enum { NBUCKETS = 1024 };
+
+    QuantileSketch() { Reset(); }
+    void Reset();
+    void Add(double v);
+    void Merge(const QuantileSketch& other);
+    // merge a sketch whose values are to be multiplied by scale (e.g. a
+    // different pixel scale); adds up to one bucket of error
+    void Merge(const QuantileSketch& other, double scale);
+    unsigned int Count() const { return m_count; }
+    // q in [0, 1]; returns 0 if the sketch is empty
+    double Quantile(double q) const;
+
+private:
+    unsigned int m_count;
+    unsigned int m_bucket[NBUCKETS]; // bucket 0 holds values below the resolution limit
+};
+
+// Running means, variances and covariance of a 2-D sample, and the
+// least squares line through it.
+//
+// Accumulators built independently (per session, or per thread) can be
+// merged exactly with the pairwise update of Chan et al., so aggregate
+// variances never need another pass over the frames.
+struct LFit
+{
+    double avx, avy, varx, covxy, vary, n;
+    LFit() : avx(0.), avy(0.), varx(0.), covxy(0.), vary(0.), n(0.) { }
+    void data(double x, double y) {
+        double k = n;
+        n += 1.0;
+        k /= n;
+        double dx = x - avx;
+        double dy = y - avy;
+        varx += (k * dx * dx - varx) / n;
+        covxy += (k * dx * dy - covxy) / n;
+        vary += (k * dy * dy - vary) / n;
+        avx += dx / n;
+        avy += dy / n;
+    }
+    void reset() {
+        avx = avy = varx = covxy = vary = n = 0.;
+    }
+    // merge a sample whose values are to be multiplied by scale
+    void merge(const LFit& other, double scale = 1.0);
+    // y = a + b x
+    double B() const { return n >= 2. ? covxy / varx : 0.; }
+    double A() const { return avy - B() * avx; }
+    void result(double *a, double *b) const {
+        *b = B();
+        *a = avy - *b * avx;
+    }
+    double Theta() const { return n >= 2. ? atan2(covxy, varx) : 0.; }
+};
+
+#endif
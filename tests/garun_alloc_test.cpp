@@ -0,0 +1,126 @@
+/*
+ * This file is part of phdlogview
+ *
+ * Copyright (C) 2026 Andy Galasso
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, visit the http://fsf.org website.
+ */
+
+// Counts the heap allocations of a guide analysis. A first run of each
+// kind of spectrum grows the GARun buffers and starts the worker pool; a
+// second run on input of the same size must not allocate at all.
+
+#include "garun.h"
+#include "logparser.h"
+
+#include <atomic>
+#include <math.h>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+
+static std::atomic<size_t> s_allocs(0);
+
+void *operator new(size_t n)
+{
+    ++s_allocs;
+    void *p = malloc(n ? n : 1);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void *operator new[](size_t n)
+{
+    return operator new(n);
+}
+
+void operator delete(void *p) throw()
+{
+    free(p);
+}
+
+void operator delete[](void *p) throw()
+{
+    free(p);
+}
+
+// 2s frames of a 480s periodic error with some noise, and a little drift
+static void MakeSession(GuideSession& session, size_t n)
+{
+    unsigned int seed = 1;
+    for (size_t i = 0; i < n; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        float noise = (float) (seed >> 16 & 0x7fff) / 32768.f - 0.5f;
+
+        GuideEntry e = GuideEntry();
+        e.frame = (int) i + 1;
+        e.dt = 2.f * (float) i;
+        e.mount = MOUNT;
+        e.included = true;
+        e.guiding = true;
+        e.raraw = (float) (1.5 * sin(2. * M_PI * e.dt / 480.)) + 0.2f * noise + 0.001f * e.dt;
+        e.decraw = 0.3f * noise;
+        e.err = 0;
+        session.entries.push_back(e);
+    }
+}
+
+static size_t Run(GARun& run, const GuideSession& session, const SpectrumOptions& opts)
+{
+    size_t const before = s_allocs;
+    run.Load(session, 0, session.entries.size(), false);
+    run.Process(opts);
+    run.CalcSpectrogram(opts.segment, opts.overlap);
+    return s_allocs - before;
+}
+
+int main()
+{
+    wxString const date;
+    GuideSession session(date);
+    MakeSession(session, 4000);
+
+    static const struct
+    {
+        const char *name;
+        SpectrumMode mode;
+    } modes[] = {
+        { "FFT", SPECTRUM_FFT },
+        { "Lomb-Scargle", SPECTRUM_LOMB_SCARGLE },
+        { "Welch", SPECTRUM_WELCH },
+    };
+
+    int ret = 0;
+    for (size_t k = 0; k < sizeof(modes) / sizeof(modes[0]); k++)
+    {
+        SpectrumOptions opts;
+        opts.mode = modes[k].mode;
+        opts.segment = 600.;
+        opts.overlap = 0.5;
+
+        GARun run;
+        size_t const first = Run(run, session, opts);
+        size_t const second = Run(run, session, opts);
+        bool ok = second == 0 && run.nfft != 0 && run.sgram.valid && run.sgram.nwin != 0;
+
+        printf("%s: %u allocations in the first run, %u in the second: %s\n", modes[k].name,
+               (unsigned int) first, (unsigned int) second, ok ? "ok" : "FAILED");
+        if (!ok)
+            ret = 1;
+    }
+
+    return ret;
+}